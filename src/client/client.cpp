@@ -137,6 +137,7 @@ void Client::init()
     SignalProxy *p = signalProxy();
 
     p->attachSlot(SIGNAL(displayMsg(const Message &)), this, SLOT(recvMessage(const Message &)));
+    p->attachSlot(SIGNAL(displayMessages(QVariantList)), this, SLOT(recvMessages(QVariantList)));
     p->attachSlot(SIGNAL(displayStatusMsg(QString, QString)), this, SLOT(recvStatusMsg(QString, QString)));
 
     p->attachSlot(SIGNAL(bufferInfoUpdated(BufferInfo)), _networkModel, SLOT(bufferUpdated(BufferInfo)));
@@ -555,6 +556,17 @@ void Client::recvMessage(const Message &msg)
 }
 
 
+void Client::recvMessages(const QVariantList &msgs)
+{
+    QList<Message> msgList;
+    msgList.reserve(msgs.count());
+    foreach(const QVariant &msg, msgs) {
+        msgList << msg.value<Message>();
+    }
+    messageProcessor()->process(msgList);
+}
+
+
 void Client::setBufferLastSeenMsg(BufferId id, const MsgId &msgId)
 {
     if (bufferSyncer())
@@ -41,22 +41,33 @@ ClientBacklogManager::ClientBacklogManager(QObject *parent)
 QVariantList ClientBacklogManager::requestBacklog(BufferId bufferId, MsgId first, MsgId last, int limit, int additional)
 {
     _buffersRequested << bufferId;
+    if (Client::coreFeatures() & Quassel::BacklogStreaming) {
+        PeerPtr peer = 0;
+        requestBacklogStream(peer, bufferId, first, last, limit, additional);
+        return QVariantList();
+    }
     return BacklogManager::requestBacklog(bufferId, first, last, limit, additional);
 }
 
 
+QVariantList ClientBacklogManager::requestBacklogAll(MsgId first, MsgId last, int limit, int additional)
+{
+    if (Client::coreFeatures() & Quassel::BacklogStreaming) {
+        PeerPtr peer = 0;
+        requestBacklogAllStream(peer, first, last, limit, additional);
+        return QVariantList();
+    }
+    return BacklogManager::requestBacklogAll(first, last, limit, additional);
+}
+
+
 void ClientBacklogManager::receiveBacklog(BufferId bufferId, MsgId first, MsgId last, int limit, int additional, QVariantList msgs)
 {
     Q_UNUSED(first) Q_UNUSED(last) Q_UNUSED(limit) Q_UNUSED(additional)
 
     emit messagesReceived(bufferId, msgs.count());
 
-    MessageList msglist;
-    foreach(QVariant v, msgs) {
-        Message msg = v.value<Message>();
-        msg.setFlags(msg.flags() | Message::Backlog);
-        msglist << msg;
-    }
+    MessageList msglist = toBacklogMessages(msgs);
 
     if (isBuffering()) {
         bool lastPart = !_requester->buffer(bufferId, msglist);
@@ -76,14 +87,55 @@ void ClientBacklogManager::receiveBacklogAll(MsgId first, MsgId last, int limit,
 {
     Q_UNUSED(first) Q_UNUSED(last) Q_UNUSED(limit) Q_UNUSED(additional)
 
+    dispatchMessages(toBacklogMessages(msgs));
+}
+
+
+void ClientBacklogManager::receiveBacklogChunk(PeerPtr, BufferId bufferId, QVariantList msgs, bool complete)
+{
+    emit messagesReceived(bufferId, msgs.count());
+
+    // chunks go straight to the message model, even if the requester is buffering.
+    // the requester only keeps track of the buffers still waiting.
+    dispatchMessages(toBacklogMessages(msgs), true);
+
+    if (complete && isBuffering()) {
+        bool lastPart = !_requester->buffer(bufferId, MessageList());
+        updateProgress(_requester->totalBuffers() - _requester->buffersWaiting(), _requester->totalBuffers());
+        if (lastPart) {
+            dispatchMessages(_requester->bufferedMessages(), true);
+            _requester->flushBuffer();
+        }
+    }
+}
+
+
+void ClientBacklogManager::receiveBacklogAllChunk(PeerPtr, QVariantList msgs, bool complete)
+{
+    Q_UNUSED(complete)
+
+    dispatchMessages(toBacklogMessages(msgs));
+}
+
+
+void ClientBacklogManager::receiveBacklogSearch(QString query, BufferId bufferId, MsgId before, int limit, int context, QVariantList results)
+{
+    Q_UNUSED(limit)
+    Q_UNUSED(context)
+
+    emit backlogSearchResults(query, bufferId, before, results);
+}
+
+
+MessageList ClientBacklogManager::toBacklogMessages(const QVariantList &msgs) const
+{
     MessageList msglist;
     foreach(QVariant v, msgs) {
         Message msg = v.value<Message>();
         msg.setFlags(msg.flags() | Message::Backlog);
         msglist << msg;
     }
-
-    dispatchMessages(msglist);
+    return msglist;
 }
 
 
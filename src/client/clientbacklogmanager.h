@@ -42,8 +42,14 @@ public:
 public slots:
     virtual QVariantList requestBacklog(BufferId bufferId, MsgId first = -1, MsgId last = -1, int limit = -1, int additional = 0);
     virtual void receiveBacklog(BufferId bufferId, MsgId first, MsgId last, int limit, int additional, QVariantList msgs);
+    virtual QVariantList requestBacklogAll(MsgId first = -1, MsgId last = -1, int limit = -1, int additional = 0);
     virtual void receiveBacklogAll(MsgId first, MsgId last, int limit, int additional, QVariantList msgs);
 
+    virtual void receiveBacklogChunk(PeerPtr, BufferId bufferId, QVariantList msgs, bool complete);
+    virtual void receiveBacklogAllChunk(PeerPtr, QVariantList msgs, bool complete);
+
+    virtual void receiveBacklogSearch(QString query, BufferId bufferId, MsgId before, int limit, int context, QVariantList results);
+
     void requestInitialBacklog();
 
     void checkForBacklog(BufferId bufferId);
@@ -56,11 +62,15 @@ signals:
 
     void updateProgress(int, int);
 
+    //! Results of a requestBacklogSearch(), see BacklogManager for their format
+    void backlogSearchResults(const QString &query, BufferId bufferId, MsgId before, const QVariantList &results);
+
 private:
     bool isBuffering();
     BufferIdList filterNewBufferIds(const BufferIdList &bufferIds);
 
     void dispatchMessages(const MessageList &messages, bool sort = false);
+    MessageList toBacklogMessages(const QVariantList &msgs) const;
 
     BacklogRequester *_requester;
     bool _initBacklogRequested;
@@ -29,6 +29,7 @@
 
 MessageFilter::MessageFilter(QAbstractItemModel *source, QObject *parent)
     : QSortFilterProxyModel(parent),
+    _messageModel(qobject_cast<MessageModel *>(source)),
     _messageTypeFilter(0)
 {
     init();
@@ -38,6 +39,7 @@ MessageFilter::MessageFilter(QAbstractItemModel *source, QObject *parent)
 
 MessageFilter::MessageFilter(MessageModel *source, const QList<BufferId> &buffers, QObject *parent)
     : QSortFilterProxyModel(parent),
+    _messageModel(source),
     _validBuffers(buffers.toSet()),
     _messageTypeFilter(0)
 {
@@ -131,8 +133,12 @@ QString MessageFilter::idString() const
 bool MessageFilter::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
     Q_UNUSED(sourceParent);
-    QModelIndex sourceIdx = sourceModel()->index(sourceRow, 2);
-    Message::Type messageType = (Message::Type)sourceIdx.data(MessageModel::TypeRole).toInt();
+    // this runs for every message of every buffer, so read the item directly instead of going through QVariant roles
+    const MessageModelItem *item = sourceItem(sourceRow);
+    if (!item)
+        return false;
+
+    Message::Type messageType = item->msgType();
 
     // apply message type filter
     if (_messageTypeFilter & messageType)
@@ -141,14 +147,19 @@ bool MessageFilter::filterAcceptsRow(int sourceRow, const QModelIndex &sourcePar
     if (_validBuffers.isEmpty())
         return true;
 
-    BufferId bufferId = sourceIdx.data(MessageModel::BufferIdRole).value<BufferId>();
+    BufferId bufferId = item->bufferId();
     if (!bufferId.isValid()) {
         return true;
     }
 
-    // MsgId msgId = sourceIdx.data(MessageModel::MsgIdRole).value<MsgId>();
-    Message::Flags flags = (Message::Flags)sourceIdx.data(MessageModel::FlagsRole).toInt();
+    Message::Flags flags = item->msgFlags();
 
+    // most messages belong to buffers we don't show at all, get rid of those before any other lookups
+    if (!(flags & Message::Redirected) && !_validBuffers.contains(bufferId)
+        && !((messageType & Message::Quit) && bufferType() == BufferInfo::QueryBuffer))
+        return false;
+
+    QModelIndex sourceIdx = sourceModel()->index(sourceRow, 2);
     NetworkId myNetworkId = networkId();
     NetworkId msgNetworkId = Client::networkModel()->networkId(bufferId);
     if (myNetworkId != msgNetworkId)
@@ -157,7 +168,7 @@ bool MessageFilter::filterAcceptsRow(int sourceRow, const QModelIndex &sourcePar
     // ignorelist handling
     // only match if message is not flagged as server msg
     if (!(flags & Message::ServerMsg) && Client::ignoreListManager()
-        && Client::ignoreListManager()->match(sourceIdx.data(MessageModel::MessageRole).value<Message>(), Client::networkModel()->networkName(bufferId)))
+        && Client::ignoreListManager()->match(item->message(), Client::networkModel()->networkName(bufferId)))
         return false;
 
     if (flags & Message::Redirected) {
@@ -185,7 +196,7 @@ bool MessageFilter::filterAcceptsRow(int sourceRow, const QModelIndex &sourcePar
             return true;
 
         if (redirectionTarget & BufferSettings::CurrentBuffer && !(flags & Message::Backlog)) {
-            BufferId redirectedTo = sourceModel()->data(sourceIdx, MessageModel::RedirectedToRole).value<BufferId>();
+            BufferId redirectedTo = item->redirectedTo();
             if (!redirectedTo.isValid()) {
                 BufferId redirectedTo = Client::bufferModel()->currentIndex().data(NetworkModel::BufferIdRole).value<BufferId>();
                 if (redirectedTo.isValid())
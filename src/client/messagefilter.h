@@ -58,9 +58,13 @@ protected:
     BufferInfo::Type bufferType() const { return Client::networkModel()->bufferType(singleBufferId()); }
     NetworkId networkId() const { return Client::networkModel()->networkId(singleBufferId()); }
 
+    //! @return the message in the given row of the source model
+    inline const MessageModelItem *sourceItem(int sourceRow) const { return _messageModel ? _messageModel->messageItem(sourceRow) : 0; }
+
 private:
     void init();
 
+    MessageModel *_messageModel;
     QSet<BufferId> _validBuffers;
     QMultiHash<QString, uint> _filteredQuitMsgs;
     int _messageTypeFilter;
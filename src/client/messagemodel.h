@@ -68,6 +68,9 @@ public:
 
     //virtual Qt::ItemFlags flags(const QModelIndex &index) const;
 
+    //! Direct access to the message in a given row, for hot paths like filtering that shouldn't go through QVariant roles
+    inline const MessageModelItem *messageItem(int row) const { return messageItemAt(row); }
+
     bool insertMessage(const Message &, bool fakeMsg = false);
     void insertMessages(const QList<Message> &);
 
@@ -151,6 +154,7 @@ public:
     virtual void setBufferId(BufferId bufferId) = 0;
     virtual Message::Type msgType() const = 0;
     virtual Message::Flags msgFlags() const = 0;
+    inline BufferId redirectedTo() const { return _redirectedTo; }
 
     // For sorting
     bool operator<(const MessageModelItem &) const;
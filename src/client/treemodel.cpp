@@ -41,7 +41,9 @@ private:
 AbstractTreeItem::AbstractTreeItem(AbstractTreeItem *parent)
     : QObject(parent),
     _flags(Qt::ItemIsSelectable | Qt::ItemIsEnabled),
-    _treeItemFlags(0)
+    _treeItemFlags(0),
+    _row(-1),
+    _validRows(0)
 {
 }
 
@@ -50,6 +52,9 @@ bool AbstractTreeItem::newChild(AbstractTreeItem *item)
 {
     int newRow = childCount();
     emit beginAppendChilds(newRow, newRow);
+    item->_row = newRow;
+    if (_validRows == newRow)
+        _validRows++;
     _childItems.append(item);
     emit endAppendChilds();
     return true;
@@ -65,6 +70,10 @@ bool AbstractTreeItem::newChilds(const QList<AbstractTreeItem *> &items)
     int lastRow = nextRow + items.count() - 1;
 
     emit beginAppendChilds(nextRow, lastRow);
+    for (int i = 0; i < items.count(); i++)
+        items[i]->_row = nextRow + i;
+    if (_validRows == nextRow)
+        _validRows = lastRow + 1;
     _childItems << items;
     emit endAppendChilds();
 
@@ -80,6 +89,7 @@ bool AbstractTreeItem::removeChild(int row)
     child(row)->removeAllChilds();
     emit beginRemoveChilds(row, row);
     AbstractTreeItem *treeitem = _childItems.takeAt(row);
+    _validRows = qMin(_validRows, row);
     delete treeitem;
     emit endRemoveChilds();
 
@@ -115,6 +125,7 @@ void AbstractTreeItem::removeAllChilds()
         childIter = _childItems.erase(childIter);
         delete child;
     }
+    _validRows = 0;
     emit endRemoveChilds();
 
     checkForDeletion();
@@ -163,6 +174,7 @@ bool AbstractTreeItem::reParent(AbstractTreeItem *newParent)
 
     emit parent()->beginRemoveChilds(oldRow, oldRow);
     parent()->_childItems.removeAt(oldRow);
+    parent()->_validRows = qMin(parent()->_validRows, oldRow);
     emit parent()->endRemoveChilds();
 
     AbstractTreeItem *oldParent = parent();
@@ -204,10 +216,25 @@ int AbstractTreeItem::row() const
         return -1;
     }
 
-    int row_ = parent()->_childItems.indexOf(const_cast<AbstractTreeItem *>(this));
-    if (row_ == -1)
+    // rows behind a removed sibling are renumbered lazily, so a bulk part only pays once
+    AbstractTreeItem *parentItem = parent();
+    if (_row >= parentItem->_validRows)
+        parentItem->updateChildRows();
+
+    if (_row < 0 || _row >= parentItem->_childItems.count() || parentItem->_childItems.at(_row) != this) {
         qWarning() << "AbstractTreeItem::row():" << this << "is not in the child list of" << QObject::parent();
-    return row_;
+        return -1;
+    }
+    return _row;
+}
+
+
+void AbstractTreeItem::updateChildRows() const
+{
+    const int numChilds = _childItems.count();
+    for (int i = _validRows; i < numChilds; i++)
+        _childItems.at(i)->_row = i;
+    _validRows = numChilds;
 }
 
 
@@ -89,6 +89,12 @@ private:
     Qt::ItemFlags _flags;
     TreeItemFlags _treeItemFlags;
 
+    //! Cached position of this item in its parent's child list
+    int _row;
+    //! Number of leading children whose _row is known to be up to date
+    mutable int _validRows;
+
+    void updateChildRows() const;
     void removeChildLater(AbstractTreeItem *child);
     inline void checkForDeletion()
     {
@@ -33,3 +33,22 @@ QVariantList BacklogManager::requestBacklogAll(MsgId first, MsgId last, int limi
     REQUEST(ARG(first), ARG(last), ARG(limit), ARG(additional))
     return QVariantList();
 }
+
+
+void BacklogManager::requestBacklogStream(PeerPtr peer, BufferId bufferId, MsgId first, MsgId last, int limit, int additional)
+{
+    REQUEST(ARG(peer), ARG(bufferId), ARG(first), ARG(last), ARG(limit), ARG(additional))
+}
+
+
+void BacklogManager::requestBacklogAllStream(PeerPtr peer, MsgId first, MsgId last, int limit, int additional)
+{
+    REQUEST(ARG(peer), ARG(first), ARG(last), ARG(limit), ARG(additional))
+}
+
+
+QVariantList BacklogManager::requestBacklogSearch(const QString &query, BufferId bufferId, MsgId before, int limit, int context)
+{
+    REQUEST(ARG(query), ARG(bufferId), ARG(before), ARG(limit), ARG(context))
+    return QVariantList();
+}
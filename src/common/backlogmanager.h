@@ -21,6 +21,7 @@
 #ifndef BACKLOGMANAGER_H
 #define BACKLOGMANAGER_H
 
+#include "peer.h"
 #include "syncableobject.h"
 #include "types.h"
 
@@ -40,6 +41,20 @@ public slots:
     virtual QVariantList requestBacklogAll(MsgId first = -1, MsgId last = -1, int limit = -1, int additional = 0);
     inline virtual void receiveBacklogAll(MsgId, MsgId, int, int, QVariantList) {};
 
+    // Streaming variants: the core answers with a series of receive*Chunk() calls to the requesting peer only,
+    // the last one having complete set. Only available if the core supports Quassel::BacklogStreaming.
+    virtual void requestBacklogStream(PeerPtr peer, BufferId bufferId, MsgId first, MsgId last, int limit, int additional);
+    inline virtual void receiveBacklogChunk(PeerPtr, BufferId, QVariantList, bool) {};
+
+    virtual void requestBacklogAllStream(PeerPtr peer, MsgId first, MsgId last, int limit, int additional);
+    inline virtual void receiveBacklogAllChunk(PeerPtr, QVariantList, bool) {};
+
+    // Search the backlog on the core. Pass the oldest MsgId of the previous result as before to get the next page.
+    // Every result is a QVariantMap holding the matching "Message", and the "Before" and "After" context messages.
+    // Only available if the core supports Quassel::BacklogSearch.
+    virtual QVariantList requestBacklogSearch(const QString &query, BufferId bufferId = BufferId(), MsgId before = -1, int limit = -1, int context = 0);
+    inline virtual void receiveBacklogSearch(QString, BufferId, MsgId, int, int, QVariantList) {};
+
 signals:
     void backlogRequested(BufferId, MsgId, MsgId, int, int);
     void backlogAllRequested(MsgId, MsgId, int, int);
@@ -37,11 +37,17 @@ Compressor::Compressor(QTcpSocket *socket, Compressor::CompressionLevel level, Q
     : QObject(parent),
     _socket(socket),
     _level(level),
+    _readOffset(0),
     _inflater(0),
-    _deflater(0)
+    _deflater(0),
+    _writeDelay(-1),
+    _writeTimer(new QTimer(this))
 {
     connect(socket, SIGNAL(readyRead()), SLOT(readData()));
 
+    _writeTimer->setSingleShot(true);
+    connect(_writeTimer, SIGNAL(timeout()), SLOT(writeData()));
+
     bool ok = true;
     if (level != NoCompression)
         ok = initStreams();
@@ -113,23 +119,18 @@ bool Compressor::initStreams()
 
 qint64 Compressor::bytesAvailable() const
 {
-    return _readBuffer.size();
+    return _readBuffer.size() - _readOffset;
 }
 
 
 qint64 Compressor::read(char *data, qint64 maxSize)
 {
     if (maxSize <= 0)
-        maxSize = _readBuffer.size();
-
-    qint64 n = qMin(maxSize, (qint64)_readBuffer.size());
-    memcpy(data, _readBuffer.constData(), n);
+        maxSize = bytesAvailable();
 
-    // TODO: don't copy for every read
-    if (n == _readBuffer.size())
-        _readBuffer.clear();
-    else
-        _readBuffer = _readBuffer.mid(n);
+    qint64 n = qMin(maxSize, bytesAvailable());
+    memcpy(data, _readBuffer.constData() + _readOffset, n);
+    _readOffset += n;
 
     // If there's still data left in the socket buffer, make sure to schedule a read
     if (_socket->bytesAvailable())
@@ -139,6 +140,19 @@ qint64 Compressor::read(char *data, qint64 maxSize)
 }
 
 
+QByteArray Compressor::readView(qint64 size)
+{
+    qint64 n = qMin(size, bytesAvailable());
+    QByteArray view = QByteArray::fromRawData(_readBuffer.constData() + _readOffset, n);
+    _readOffset += n;
+
+    if (_socket->bytesAvailable())
+        QTimer::singleShot(0, this, SLOT(readData()));
+
+    return view;
+}
+
+
 // The usual usage pattern is to write a blocksize first, followed by the actual data.
 // By setting NoFlush, one can indicate that the write buffer should not immediately be
 // written, which should make things a bit more efficient.
@@ -148,24 +162,53 @@ qint64 Compressor::write(const char *data, qint64 count, WriteBufferHint flush)
     _writeBuffer.resize(pos + count);
     memcpy(_writeBuffer.data() + pos, data, count);
 
-    if (flush != NoFlush)
+    if (flush == NoFlush)
+        return count;
+
+    _statistics.frames++;
+
+    // hold back small writes if asked to, so they can share a deflate call and a socket write
+    if (_writeDelay < 0 || _writeBuffer.size() >= ioBufferSize)
         writeData();
+    else if (!_writeTimer->isActive())
+        _writeTimer->start(_writeDelay);
 
     return count;
 }
 
 
+void Compressor::setWriteDelay(int msecs)
+{
+    _writeDelay = msecs;
+    if (msecs < 0 && !_writeBuffer.isEmpty())
+        writeData();
+}
+
+
 void Compressor::readData()
 {
     // don't try to read more data if we're already closing
     if (_socket->state() !=  QAbstractSocket::ConnectedState)
         return;
 
+    // Drop what has been consumed since the last call. Doing this here rather than in read() means that we only
+    // move the (usually small) unconsumed tail once per chunk of incoming data, instead of once per message.
+    if (_readOffset > 0) {
+        if (_readOffset == _readBuffer.size())
+            _readBuffer.clear();
+        else
+            _readBuffer.remove(0, _readOffset);
+        _readOffset = 0;
+    }
+
     if (!_socket->bytesAvailable() || _readBuffer.size() >= maxBufferSize)
         return;
 
     if (compressionLevel() == NoCompression) {
+        int oldSize = _readBuffer.size();
         _readBuffer.append(_socket->read(maxBufferSize - _readBuffer.size()));
+        _statistics.bytesIn += _readBuffer.size() - oldSize;
+        _statistics.wireBytesIn += _readBuffer.size() - oldSize;
         emit readyRead();
         return;
     }
@@ -178,7 +221,9 @@ void Compressor::readData()
 
     while (_socket->bytesAvailable() && _readBuffer.size() + ioBufferSize < maxBufferSize && _inputBuffer.size() < ioBufferSize) {
         _readBuffer.resize(_readBuffer.size() + ioBufferSize);
+        int inputSize = _inputBuffer.size();
         _inputBuffer.append(_socket->read(ioBufferSize - _inputBuffer.size()));
+        _statistics.wireBytesIn += _inputBuffer.size() - inputSize;
 
         _inflater->next_in = reinterpret_cast<unsigned char *>(_inputBuffer.data());
         _inflater->avail_in = _inputBuffer.size();
@@ -190,6 +235,7 @@ void Compressor::readData()
         int status = inflate(_inflater, Z_SYNC_FLUSH); // get as much data as possible
 
         // adjust input and output buffers
+        _statistics.bytesIn += _inflater->next_out - orig_out;
         _readBuffer.resize(_inflater->next_out - reinterpret_cast<unsigned char *>(_readBuffer.data()));
         if (_inflater->avail_in > 0)
             memmove(_inputBuffer.data(), _inflater->next_in, _inflater->avail_in);
@@ -223,8 +269,17 @@ void Compressor::readData()
 
 void Compressor::writeData()
 {
+    _writeTimer->stop();
+    if (_writeBuffer.isEmpty())
+        return;
+
+    _statistics.flushes++;
+    _statistics.bytesOut += _writeBuffer.size();
+
     if (compressionLevel() == NoCompression) {
-        _socket->write(_writeBuffer);
+        qint64 written = _socket->write(_writeBuffer);
+        if (written > 0)
+            _statistics.wireBytesOut += written;
         _writeBuffer.clear();
         return;
     }
@@ -251,6 +306,7 @@ void Compressor::writeData()
             emit error(DeviceError);
             return;
         }
+        _statistics.wireBytesOut += ioBufferSize - _deflater->avail_out;
     } while (_deflater->avail_out == 0); // the output buffer being full is the only reason we should have to loop here!
 
     if (_deflater->avail_in > 0) {
@@ -266,8 +322,9 @@ void Compressor::writeData()
 
 void Compressor::flush()
 {
-    if (compressionLevel() == NoCompression && _socket->state() == QAbstractSocket::ConnectedState)
-        _socket->flush();
+    if (!_writeBuffer.isEmpty())
+        writeData();
 
-    // FIXME: missing impl for enabled compression; but then we're not using this method yet
+    if (_socket->state() == QAbstractSocket::ConnectedState)
+        _socket->flush();
 }
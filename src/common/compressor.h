@@ -24,6 +24,7 @@
 #include <QObject>
 
 class QTcpSocket;
+class QTimer;
 
 #ifdef HAVE_ZLIB
     typedef struct z_stream_s *z_streamp;
@@ -54,14 +55,37 @@ public:
         Flush
     };
 
+    //! Transfer counters; "wire" bytes are the ones actually read from or written to the socket
+    struct Statistics {
+        quint64 bytesIn;
+        quint64 wireBytesIn;
+        quint64 bytesOut;
+        quint64 wireBytesOut;
+        quint64 frames;  // writes with a Flush hint, i.e. complete messages
+        quint64 flushes; // times the write buffer was handed to the socket
+        Statistics() : bytesIn(0), wireBytesIn(0), bytesOut(0), wireBytesOut(0), frames(0), flushes(0) {}
+    };
+
     Compressor(QTcpSocket *socket, CompressionLevel level, QObject *parent = 0);
     ~Compressor();
 
     CompressionLevel compressionLevel() const { return _level; }
+    const Statistics &statistics() const { return _statistics; }
+
+    //! Sets how long (in ms) flushed writes may be held back to be sent together with later ones
+    /** With a delay of 0, everything written during one event loop iteration is compressed and sent at once.
+     *  A negative delay (the default) sends each flushed write right away. Pending data is written immediately.
+     */
+    void setWriteDelay(int msecs);
 
     qint64 bytesAvailable() const;
 
     qint64 read(char *data, qint64 maxSize);
+    //! Consumes up to size bytes and returns them without copying
+    /** The returned array refers to the internal read buffer. It stays valid until control returns to the event loop,
+     *  so callers that need to keep the data around longer have to make a deep copy.
+     */
+    QByteArray readView(qint64 size);
     qint64 write(const char *data, qint64 count, WriteBufferHint flush = Flush);
 
     void flush();
@@ -72,16 +96,17 @@ signals:
 
 private slots:
     void readData();
+    void writeData();
 
 private:
     bool initStreams();
-    void writeData();
 
 private:
     QTcpSocket *_socket;
     CompressionLevel _level;
 
     QByteArray _readBuffer;
+    int _readOffset; // consumed bytes at the start of _readBuffer, dropped on the next readData()
     QByteArray _writeBuffer;
 
     QByteArray _inputBuffer;
@@ -89,6 +114,10 @@ private:
 
     z_streamp _inflater;
     z_streamp _deflater;
+
+    int _writeDelay;
+    QTimer *_writeTimer;
+    Statistics _statistics;
 };
 
 #endif
@@ -23,6 +23,94 @@
 #include "networkevent.h"
 #include "messageevent.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+
+// Freed events are kept in one free list per size class, so the steady state
+// of the parsing and dispatch pipeline doesn't touch the heap anymore.
+const size_t poolGranularity = 16;
+const size_t poolSizeClasses = 32; // i.e. events up to 512 bytes are pooled
+const int maxPooledBlocks = 256;   // per size class
+
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+struct EventPool {
+    QMutex mutex;
+    FreeBlock *freeLists[poolSizeClasses];
+    int freeCounts[poolSizeClasses];
+    quint64 allocations;
+    quint64 heapAllocations;
+
+    EventPool() : allocations(0), heapAllocations(0)
+    {
+        for (size_t i = 0; i < poolSizeClasses; i++) {
+            freeLists[i] = 0;
+            freeCounts[i] = 0;
+        }
+    }
+};
+
+static EventPool *eventPool()
+{
+    // deliberately never deleted, as events may still be destroyed during static destruction
+    static EventPool *pool = new EventPool;
+    return pool;
+}
+
+
+void *Event::operator new(size_t size)
+{
+    EventPool *pool = eventPool();
+    size_t sizeClass = (size - 1) / poolGranularity;
+
+    QMutexLocker locker(&pool->mutex);
+    pool->allocations++;
+    if (sizeClass < poolSizeClasses && pool->freeLists[sizeClass]) {
+        FreeBlock *block = pool->freeLists[sizeClass];
+        pool->freeLists[sizeClass] = block->next;
+        pool->freeCounts[sizeClass]--;
+        return block;
+    }
+    pool->heapAllocations++;
+    locker.unlock();
+
+    // always allocate the full size class, so the block can be reused by any event of that class
+    return ::operator new(sizeClass < poolSizeClasses ? (sizeClass + 1) * poolGranularity : size);
+}
+
+
+void Event::operator delete(void *ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    EventPool *pool = eventPool();
+    size_t sizeClass = (size - 1) / poolGranularity;
+    if (sizeClass < poolSizeClasses) {
+        QMutexLocker locker(&pool->mutex);
+        if (pool->freeCounts[sizeClass] < maxPooledBlocks) {
+            FreeBlock *block = static_cast<FreeBlock *>(ptr);
+            block->next = pool->freeLists[sizeClass];
+            pool->freeLists[sizeClass] = block;
+            pool->freeCounts[sizeClass]++;
+            return;
+        }
+    }
+    ::operator delete(ptr);
+}
+
+
+void Event::allocationStats(quint64 &allocations, quint64 &heapAllocations)
+{
+    EventPool *pool = eventPool();
+    QMutexLocker locker(&pool->mutex);
+    allocations = pool->allocations;
+    heapAllocations = pool->heapAllocations;
+}
+
+
 Event::Event(EventManager::EventType type)
     : _type(type)
     , _valid(true)
@@ -55,6 +55,14 @@ public:
     static Event *fromVariantMap(QVariantMap &map, Network *network);
     QVariantMap toVariantMap() const;
 
+    // The core creates and deletes several events per IRC line, so we recycle their memory
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
+    //! Number of event allocations so far, and how many of them needed a fresh heap block
+    /** Process-wide; reported via CoreInfo ("eventAllocations") and EventManager::dumpDispatchStats() */
+    static void allocationStats(quint64 &allocations, quint64 &heapAllocations);
+
 protected:
     virtual inline QString className() const { return "Event"; }
     virtual inline void debugInfo(QDebug &dbg) const { Q_UNUSED(dbg); }
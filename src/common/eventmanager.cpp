@@ -23,6 +23,8 @@
 #include <QCoreApplication>
 #include <QEvent>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QVarLengthArray>
 
 #include "event.h"
 #include "ircevent.h"
@@ -33,9 +35,9 @@
 class QueuedQuasselEvent : public QEvent
 {
 public:
-    QueuedQuasselEvent(Event *event)
-        : QEvent(QEvent::User), event(event) {}
-    Event *event;
+    QueuedQuasselEvent(const QList<Event *> &events)
+        : QEvent(QEvent::User), events(events) {}
+    QList<Event *> events;
 };
 
 
@@ -67,6 +69,47 @@ EventManager::EventType EventManager::eventTypeByName(const QString &name)
 }
 
 
+QHash<QByteArray, EventManager::EventType> EventManager::buildIrcCommandTypes()
+{
+    // built from the enum, so new IrcEvent types are picked up automatically
+    // (not via eventEnum(), which isn't safe to call from several threads at once)
+    QMetaEnum eventTypes = staticMetaObject.enumerator(staticMetaObject.indexOfEnumerator("EventType"));
+    QHash<QByteArray, EventType> ircCommandTypes;
+    for (int i = 0; i < eventTypes.keyCount(); i++) {
+        QByteArray key = eventTypes.key(i);
+        EventType type = static_cast<EventType>(eventTypes.value(i));
+        if (!key.startsWith("IrcEvent") || key.length() == 8 || (type & EventGroupMask) != IrcEvent)
+            continue;
+        if (type == IrcEventRawPrivmsg || type == IrcEventRawNotice || type == IrcEventUnknown)
+            continue;
+        if (type == IrcEventNumeric)
+            continue;
+        ircCommandTypes[key.mid(8).toUpper()] = type;
+    }
+    return ircCommandTypes;
+}
+
+
+EventManager::EventType EventManager::ircEventTypeByCommand(const QByteArray &command)
+{
+    // The parsers of all sessions get here from their own threads, so rely on the initialization of a
+    // function-local static being thread-safe rather than filling a shared hash on first use
+    static const QHash<QByteArray, EventType> ircCommandTypes = buildIrcCommandTypes();
+
+    // commands are case insensitive, but servers practically always send them in upper case
+    QHash<QByteArray, EventType>::const_iterator it = ircCommandTypes.constFind(command);
+    if (it == ircCommandTypes.constEnd()) {
+        QByteArray upperCommand = command.toUpper();
+        if (upperCommand == command)
+            return Invalid;
+        it = ircCommandTypes.constFind(upperCommand);
+        if (it == ircCommandTypes.constEnd())
+            return Invalid;
+    }
+    return it.value();
+}
+
+
 EventManager::EventType EventManager::eventGroupByName(const QString &name)
 {
     EventType type = eventTypeByName(name);
@@ -167,6 +210,7 @@ void EventManager::registerObject(QObject *object, Priority priority, const QStr
             //qDebug() << "Registered event filterer for" << methodSignature << "in" << object;
         }
     }
+    invalidateDispatchTables();
 }
 
 
@@ -206,13 +250,14 @@ void EventManager::registerEventHandler(QList<EventType> events, QObject *object
             qDebug() << "Registered event handler for" << event << "in" << object;
         }
     }
+    invalidateDispatchTables();
 }
 
 
 void EventManager::postEvent(Event *event)
 {
     if (sender() && sender()->thread() != this->thread()) {
-        QueuedQuasselEvent *queuedEvent = new QueuedQuasselEvent(event);
+        QueuedQuasselEvent *queuedEvent = new QueuedQuasselEvent(QList<Event *>() << event);
         QCoreApplication::postEvent(this, queuedEvent);
     }
     else {
@@ -225,16 +270,44 @@ void EventManager::postEvent(Event *event)
 }
 
 
+void EventManager::postEvents(const QList<Event *> &events)
+{
+    if (events.isEmpty())
+        return;
+
+    if (sender() && sender()->thread() != this->thread()) {
+        // one queued event for the whole batch
+        QueuedQuasselEvent *queuedEvent = new QueuedQuasselEvent(events);
+        QCoreApplication::postEvent(this, queuedEvent);
+    }
+    else {
+        if (_eventQueue.isEmpty())
+            processEvents(events);
+        else
+            _eventQueue.append(events);
+    }
+}
+
+
 void EventManager::customEvent(QEvent *event)
 {
     if (event->type() == QEvent::User) {
         QueuedQuasselEvent *queuedEvent = static_cast<QueuedQuasselEvent *>(event);
-        processEvent(queuedEvent->event);
+        processEvents(queuedEvent->events);
         event->accept();
     }
 }
 
 
+void EventManager::processEvents(const QList<Event *> &events)
+{
+    // every event, including whatever it generates, is processed completely before the next one;
+    // e.g. the parsing of an IRC line may depend on the network state set by the previous line
+    foreach(Event *event, events)
+        processEvent(event);
+}
+
+
 void EventManager::processEvent(Event *event)
 {
     Q_ASSERT(_eventQueue.isEmpty());
@@ -251,56 +324,50 @@ void EventManager::dispatchEvent(Event *event)
 {
     //qDebug() << "Dispatching" << event;
 
-    // we try handlers from specialized to generic by masking the enum
-
-    // build a list sorted by priorities that contains all eligible handlers
-    QList<Handler> handlers;
-    QHash<QObject *, Handler> filters;
-    QSet<QObject *> ignored;
     uint type = event->type();
 
-    bool checkDupes = false;
-
-    // special handling for numeric IrcEvents
+    // special handling for numeric IrcEvents: they have their own table per numeric
     if ((type & ~IrcEventNumericMask) == IrcEventNumeric) {
         ::IrcEventNumeric *numEvent = static_cast< ::IrcEventNumeric *>(event);
         if (!numEvent)
             qWarning() << "Invalid event type for IrcEventNumeric!";
-        else {
-            int num = numEvent->number();
-            if (num > 0) {
-                insertHandlers(registeredHandlers().value(type + num), handlers, false);
-                insertFilters(registeredFilters().value(type + num), filters);
-                checkDupes = true;
-            }
-        }
+        else if (numEvent->number() > 0)
+            type += numEvent->number();
     }
 
-    // exact type
-    insertHandlers(registeredHandlers().value(type), handlers, checkDupes);
-    insertFilters(registeredFilters().value(type), filters);
+    DispatchTable &table = _dispatchTables[type];
+    if (!table.valid)
+        buildDispatchTable(type, table);
 
-    // check if we have a generic handler for the event group
-    if ((type & EventGroupMask) != type) {
-        insertHandlers(registeredHandlers().value(type & EventGroupMask), handlers, true);
-        insertFilters(registeredFilters().value(type & EventGroupMask), filters);
-    }
+    QElapsedTimer timer;
+    timer.start();
+
+    // objects whose filter rejected the event; there's hardly ever more than a few
+    QVarLengthArray<QObject *, 8> ignored;
 
     // now dispatch the event
-    QList<Handler>::const_iterator it;
-    for (it = handlers.begin(); it != handlers.end() && !event->isStopped(); ++it) {
+    // note that handlers might register new handlers, which rebuilds the table, so we work on a copy
+    QVector<DispatchEntry> entries = table.entries;
+    QVector<DispatchEntry>::const_iterator it;
+    for (it = entries.constBegin(); it != entries.constEnd() && !event->isStopped(); ++it) {
         QObject *obj = it->object;
 
-        if (ignored.contains(obj)) // object has filtered the event
-            continue;
+        if (it->filterIndex >= 0) { // we have a filter, so let's check if we want to deliver the event
+            bool filtered = false;
+            for (int i = 0; i < ignored.size(); i++) {
+                if (ignored.at(i) == obj) {
+                    filtered = true;
+                    break;
+                }
+            }
+            if (filtered) // object has filtered the event
+                continue;
 
-        if (filters.contains(obj)) { // we have a filter, so let's check if we want to deliver the event
-            Handler filter = filters.value(obj);
             bool result = false;
             void *param[] = { Q_RETURN_ARG(bool, result).data(), Q_ARG(Event *, event).data() };
-            obj->qt_metacall(QMetaObject::InvokeMetaMethod, filter.methodIndex, param);
+            obj->qt_metacall(QMetaObject::InvokeMetaMethod, it->filterIndex, param);
             if (!result) {
-                ignored.insert(obj);
+                ignored.append(obj);
                 continue; // mmmh, event filter told us to not accept
             }
         }
@@ -310,11 +377,116 @@ void EventManager::dispatchEvent(Event *event)
         obj->qt_metacall(QMetaObject::InvokeMetaMethod, it->methodIndex, param);
     }
 
+    // the table might have been replaced by a handler registering new ones
+    DispatchTable &stats = _dispatchTables[type];
+    stats.dispatchCount++;
+    stats.handlerTime += timer.nsecsElapsed();
+
     // that's it
     delete event;
 }
 
 
+void EventManager::buildDispatchTable(uint type, DispatchTable &table)
+{
+    // we try handlers from specialized to generic by masking the enum
+
+    // build a list sorted by priorities that contains all eligible handlers
+    QList<Handler> handlers;
+    QHash<QObject *, Handler> filters;
+
+    bool checkDupes = false;
+    uint baseType = type;
+
+    // numeric IrcEvents: handlers for this specific numeric come first
+    if ((type & ~IrcEventNumericMask) == IrcEventNumeric && type != IrcEventNumeric) {
+        baseType = IrcEventNumeric;
+        insertHandlers(registeredHandlers().value(type), handlers, false);
+        insertFilters(registeredFilters().value(type), filters);
+        checkDupes = true;
+    }
+
+    // exact type
+    insertHandlers(registeredHandlers().value(baseType), handlers, checkDupes);
+    insertFilters(registeredFilters().value(baseType), filters);
+
+    // check if we have a generic handler for the event group
+    if ((baseType & EventGroupMask) != baseType) {
+        insertHandlers(registeredHandlers().value(baseType & EventGroupMask), handlers, true);
+        insertFilters(registeredFilters().value(baseType & EventGroupMask), filters);
+    }
+
+    table.entries.clear();
+    table.entries.reserve(handlers.count());
+    foreach(const Handler &handler, handlers) {
+        DispatchEntry entry;
+        entry.object = handler.object;
+        entry.methodIndex = handler.methodIndex;
+        entry.filterIndex = filters.contains(handler.object) ? filters.value(handler.object).methodIndex : -1;
+        table.entries.append(entry);
+    }
+    table.valid = true;
+}
+
+
+void EventManager::invalidateDispatchTables()
+{
+    // keep the statistics, the tables get rebuilt on their next use
+    QHash<uint, DispatchTable>::iterator it;
+    for (it = _dispatchTables.begin(); it != _dispatchTables.end(); ++it)
+        it->valid = false;
+}
+
+
+// numerics have one dispatch table per number
+static QString dispatchTableName(uint type)
+{
+    if ((type & ~EventManager::IrcEventNumericMask) == EventManager::IrcEventNumeric && type != EventManager::IrcEventNumeric)
+        return QString("IrcEvent%1").arg(type & EventManager::IrcEventNumericMask, 3, 10, QLatin1Char('0'));
+    return EventManager::enumName(type);
+}
+
+
+QVariantMap EventManager::dispatchStats() const
+{
+    QVariantMap stats;
+    QHash<uint, DispatchTable>::const_iterator it;
+    for (it = _dispatchTables.constBegin(); it != _dispatchTables.constEnd(); ++it) {
+        if (!it->dispatchCount)
+            continue;
+        QVariantMap typeStats;
+        typeStats["events"] = it->dispatchCount;
+        typeStats["handlers"] = it->entries.count();
+        typeStats["handlerTime"] = it->handlerTime / 1000;
+        stats[dispatchTableName(it.key())] = typeStats;
+    }
+    return stats;
+}
+
+
+void EventManager::dumpDispatchStats() const
+{
+    quint64 allocations, heapAllocations;
+    Event::allocationStats(allocations, heapAllocations);
+
+    // the allocation counts are process-wide, so per line is only exact with a single session
+    quint64 lines = _dispatchTables.value(NetworkIncoming).dispatchCount;
+    qDebug() << this;
+    qDebug() << "event allocations:" << allocations << "(" << heapAllocations << "from the heap )";
+    if (lines)
+        qDebug() << "event allocations per line:" << double(allocations) / lines
+                 << "(" << double(heapAllocations) / lines << "from the heap )";
+    QHash<uint, DispatchTable>::const_iterator it;
+    for (it = _dispatchTables.constBegin(); it != _dispatchTables.constEnd(); ++it) {
+        qDebug() << qPrintable(QString("%1: %2 events, %3 handlers, %4 us in handlers")
+                               .arg(dispatchTableName(it.key()), 20)
+                               .arg(it->dispatchCount)
+                               .arg(it->entries.count())
+                               .arg(it->handlerTime / 1000));
+    }
+}
+
+
 void EventManager::insertHandlers(const QList<Handler> &newHandlers, QList<Handler> &existing, bool checkDupes)
 {
     foreach(const Handler &handler, newHandlers) {
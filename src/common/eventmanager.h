@@ -22,6 +22,7 @@
 #define EVENTMANAGER_H
 
 #include <QMetaEnum>
+#include <QVector>
 
 #include "types.h"
 
@@ -120,12 +121,20 @@ public :
     EventManager(QObject *parent = 0);
 
     static EventType eventTypeByName(const QString &name);
+    //! Map a non-numeric IRC command (e.g. "PRIVMSG") to its IrcEvent type, Invalid if there is none
+    static EventType ircEventTypeByCommand(const QByteArray &command);
     static EventType eventGroupByName(const QString &name);
     static QString enumName(EventType type);
     static QString enumName(int type); // for sanity tests
 
     Event *createEvent(const QVariantMap &map);
 
+    //! Number of dispatched events, handlers and time spent in them (in us), per event type name
+    /** Exposed to clients via CoreInfo ("sessionEventDispatch") */
+    QVariantMap dispatchStats() const;
+    //! Print the number of dispatched events and the time spent in their handlers, per event type
+    void dumpDispatchStats() const;
+
 public slots:
     void registerObject(QObject *object, Priority priority = NormalPriority,
         const QString &methodPrefix = "process",
@@ -145,6 +154,13 @@ public slots:
      */
     void postEvent(Event *event);
 
+    //! Send a batch of events to the registered handlers, in order
+    /** Cheaper than posting the events one by one, in particular across threads.
+      The EventManager takes ownership of the events.
+      @param events The events to be dispatched
+     */
+    void postEvents(const QList<Event *> &events);
+
 protected:
     virtual Network *networkById(NetworkId id) const = 0;
     virtual void customEvent(QEvent *event);
@@ -165,6 +181,23 @@ private:
 
     typedef QHash<uint, QList<Handler> > HandlerHash;
 
+    //! A handler together with the filter of its object, if any
+    struct DispatchEntry {
+        QObject *object;
+        int methodIndex;
+        int filterIndex; ///< -1 if the object has no filter for this event type
+    };
+
+    //! All handlers for one concrete event type (numerics included), in dispatch order
+    struct DispatchTable {
+        bool valid;
+        QVector<DispatchEntry> entries;
+        quint64 dispatchCount;
+        qint64 handlerTime; ///< in nanoseconds
+
+        DispatchTable() : valid(false), dispatchCount(0), handlerTime(0) {}
+    };
+
     inline const HandlerHash &registeredHandlers() const { return _registeredHandlers; }
     inline HandlerHash &registeredHandlers() { return _registeredHandlers; }
 
@@ -179,13 +212,22 @@ private:
     int findEventType(const QString &methodSignature, const QString &methodPrefix) const;
 
     void processEvent(Event *event);
+    void processEvents(const QList<Event *> &events);
     void dispatchEvent(Event *event);
 
+    //! Merge the registered handlers and filters for a concrete event type into its dispatch table
+    void buildDispatchTable(uint type, DispatchTable &table);
+    //! Needs to be called whenever the handler or filter registry changes
+    void invalidateDispatchTables();
+
     //! @return the EventType enum
     static QMetaEnum eventEnum();
+    //! @return the IrcEvent types by their (upper case) IRC command, used by ircEventTypeByCommand()
+    static QHash<QByteArray, EventType> buildIrcCommandTypes();
 
     HandlerHash _registeredHandlers;
     HandlerHash _registeredFilters;
+    QHash<uint, DispatchTable> _dispatchTables;
     QList<Event *> _eventQueue;
     static QMetaEnum _enum;
 };
@@ -32,6 +32,7 @@ IgnoreListManager &IgnoreListManager::operator=(const IgnoreListManager &other)
 
     SyncableObject::operator=(other);
     _ignoreList = other._ignoreList;
+    _scopeMatchers.clear();
     return *this;
 }
 
@@ -96,6 +97,7 @@ void IgnoreListManager::initSetIgnoreList(const QVariantMap &ignoreList)
     }
 
     _ignoreList.clear();
+    _scopeMatchers.clear();
     for (int i = 0; i < ignoreRule.count(); i++) {
         _ignoreList << IgnoreListItem(static_cast<IgnoreType>(ignoreType[i].toInt()), ignoreRule[i], isRegEx[i].toBool(),
             static_cast<StrictnessType>(strictness[i].toInt()), static_cast<ScopeType>(scope[i].toInt()),
@@ -132,17 +134,15 @@ IgnoreListManager::StrictnessType IgnoreListManager::_match(const QString &msgCo
     if (!(msgType & (Message::Plain | Message::Notice | Message::Action)))
         return UnmatchedStrictness;
 
-    foreach(IgnoreListItem item, _ignoreList) {
+    foreach(const IgnoreListItem &item, _ignoreList) {
         if (!item.isActive || item.type == CtcpIgnore)
             continue;
         if (item.scope == GlobalScope
             || (item.scope == NetworkScope && scopeMatch(item.scopeRule, network))
             || (item.scope == ChannelScope && scopeMatch(item.scopeRule, bufferName))) {
-            QString str;
-            if (item.type == MessageIgnore)
-                str = msgContents;
-            else
-                str = msgSender;
+            const QString &str = item.type == MessageIgnore ? msgContents : msgSender;
+            if (!item.literal.isEmpty() && !str.contains(item.literal, Qt::CaseInsensitive))
+                continue;
 
 //      qDebug() << "IgnoreListManager::match: ";
 //      qDebug() << "string: " << str;
@@ -162,21 +162,69 @@ IgnoreListManager::StrictnessType IgnoreListManager::_match(const QString &msgCo
 
 bool IgnoreListManager::scopeMatch(const QString &scopeRule, const QString &string) const
 {
+    const ScopeMatcher &matcher = scopeMatcher(scopeRule);
+    if (matcher.names.contains(string.toLower()))
+        return true;
+
+    for (int i = 0; i < matcher.wildcards.count(); i++) {
+        const QString &literal = matcher.literals.at(i);
+        if (!literal.isEmpty() && !string.contains(literal, Qt::CaseInsensitive))
+            continue;
+        if (matcher.wildcards.at(i).exactMatch(string))
+            return true;
+    }
+    return false;
+}
+
+
+const IgnoreListManager::ScopeMatcher &IgnoreListManager::scopeMatcher(const QString &scopeRule) const
+{
+    QHash<QString, ScopeMatcher>::const_iterator it = _scopeMatchers.constFind(scopeRule);
+    if (it != _scopeMatchers.constEnd())
+        return it.value();
+
+    ScopeMatcher matcher;
     foreach(QString rule, scopeRule.split(";")) {
-        QRegExp ruleRx = QRegExp(rule.trimmed());
+        rule = rule.trimmed();
+        if (!rule.contains('*') && !rule.contains('?') && !rule.contains('[')) {
+            matcher.names.insert(rule.toLower());
+            continue;
+        }
+        QRegExp ruleRx = QRegExp(rule);
         ruleRx.setCaseSensitivity(Qt::CaseInsensitive);
         ruleRx.setPatternSyntax(QRegExp::Wildcard);
-        if (ruleRx.exactMatch(string)) {
-            return true;
+        matcher.wildcards << ruleRx;
+        matcher.literals << wildcardLiteral(rule);
+    }
+    return _scopeMatchers.insert(scopeRule, matcher).value();
+}
+
+
+QString IgnoreListManager::wildcardLiteral(const QString &pattern)
+{
+    // character classes would need real parsing, and are rare enough to not bother
+    if (pattern.contains('['))
+        return QString();
+
+    int bestStart = 0, bestLength = 0;
+    int start = 0;
+    for (int i = 0; i <= pattern.length(); i++) {
+        if (i == pattern.length() || pattern.at(i) == '*' || pattern.at(i) == '?') {
+            if (i - start > bestLength) {
+                bestStart = start;
+                bestLength = i - start;
+            }
+            start = i + 1;
         }
     }
-    return false;
+    return pattern.mid(bestStart, bestLength);
 }
 
 
 void IgnoreListManager::removeIgnoreListItem(const QString &ignoreRule)
 {
     removeAt(indexOf(ignoreRule));
+    _scopeMatchers.clear();
     SYNC(ARG(ignoreRule))
 }
 
@@ -193,7 +241,7 @@ void IgnoreListManager::toggleIgnoreRule(const QString &ignoreRule)
 
 bool IgnoreListManager::ctcpMatch(const QString sender, const QString &network, const QString &type)
 {
-    foreach(IgnoreListItem item, _ignoreList) {
+    foreach(const IgnoreListItem &item, _ignoreList) {
         if (!item.isActive)
             continue;
         if (item.scope == GlobalScope || (item.scope == NetworkScope && scopeMatch(item.scopeRule, network))) {
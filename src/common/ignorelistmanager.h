@@ -21,8 +21,10 @@
 #ifndef IGNORELISTMANAGER_H
 #define IGNORELISTMANAGER_H
 
-#include <QString>
+#include <QHash>
 #include <QRegExp>
+#include <QSet>
+#include <QString>
 
 #include "message.h"
 #include "syncableobject.h"
@@ -62,6 +64,7 @@ public:
         QString scopeRule;
         bool isActive;
         QRegExp regEx;
+        QString literal; // a part of the rule any match must contain (wildcard rules only), to skip the regex early
         IgnoreListItem() {}
         IgnoreListItem(IgnoreType type_, const QString &ignoreRule_, bool isRegEx_, StrictnessType strictness_,
             ScopeType scope_, const QString &scopeRule_, bool isActive_)
@@ -69,6 +72,7 @@ public:
             regEx.setCaseSensitivity(Qt::CaseInsensitive);
             if (!isRegEx_) {
                 regEx.setPatternSyntax(QRegExp::Wildcard);
+                literal = wildcardLiteral(ignoreRule_);
             }
         }
         bool operator!=(const IgnoreListItem &other)
@@ -84,6 +88,9 @@ public:
     };
     typedef QList<IgnoreListItem> IgnoreList;
 
+    //! @return the longest part of a wildcard pattern that any matching string must contain, or an empty string
+    static QString wildcardLiteral(const QString &pattern);
+
     int indexOf(const QString &ignore) const;
     inline bool contains(const QString &ignore) const { return indexOf(ignore) != -1; }
     inline bool isEmpty() const { return _ignoreList.isEmpty(); }
@@ -146,7 +153,7 @@ public slots:
         int scope, const QString &scopeRule, bool isActive);
 
 protected:
-    void setIgnoreList(const QList<IgnoreListItem> &ignoreList) { _ignoreList = ignoreList; }
+    void setIgnoreList(const QList<IgnoreListItem> &ignoreList) { _ignoreList = ignoreList; _scopeMatchers.clear(); }
     bool scopeMatch(const QString &scopeRule, const QString &string) const; // scopeRule is a ';'-separated list, string is a network/channel-name
 
     StrictnessType _match(const QString &msgContents, const QString &msgSender, Message::Type msgType, const QString &network, const QString &bufferName);
@@ -155,7 +162,17 @@ signals:
     void ignoreAdded(IgnoreType type, const QString &ignoreRule, bool isRegex, StrictnessType strictness, ScopeType scope, const QVariant &scopeRule, bool isActive);
 
 private:
+    //! A compiled scope rule
+    struct ScopeMatcher {
+        QSet<QString> names;      // lower case fragments without wildcards, matched exactly
+        QList<QRegExp> wildcards; // the other fragments
+        QStringList literals;     // see wildcardLiteral(), one per wildcard
+    };
+
+    const ScopeMatcher &scopeMatcher(const QString &scopeRule) const;
+
     IgnoreList _ignoreList;
+    mutable QHash<QString, ScopeMatcher> _scopeMatchers; // keyed by scope rule, so edited items can't get a stale one
 };
 
 
@@ -137,6 +137,7 @@ int main(int argc, char **argv)
     cliParser->addOption("configdir", 'c', "Specify the directory holding configuration files, the SQlite database and the SSL certificate", "path");
 #endif
     cliParser->addOption("datadir", 0, "DEPRECATED - Use --configdir instead", "path");
+    cliParser->addOption("write-coalescing", 0, "Time outgoing messages may be held back to be compressed and sent together with others, -1 sends each one immediately", "ms", "0");
 
 #ifndef BUILD_CORE
     // put client-only arguments here
@@ -156,6 +157,13 @@ int main(int argc, char **argv)
     cliParser->addSwitch("syslog", 0, "Log to syslog");
 #endif
     cliParser->addOption("logfile", 'l', "Log to a file", "path");
+    cliParser->addOption("sqlite-commit-window", 0, "Time the SQLite backend waits to combine messages of all sessions into one transaction", "ms", "0");
+    cliParser->addOption("sqlite-commit-batch", 0, "Number of queued messages that triggers an early SQLite group commit", "count", "1000");
+    cliParser->addSwitch("sqlite-wal", 0, "Use SQLite's write-ahead log so backlog requests don't block message logging");
+    cliParser->addOption("sqlite-synchronous", 0, "SQLite synchronous mode OFF|NORMAL|FULL", "mode", "FULL");
+    cliParser->addOption("sqlite-wal-autocheckpoint", 0, "Number of WAL pages after which SQLite runs an automatic checkpoint", "pages", "1000");
+    cliParser->addOption("backlog-retention-interval", 0, "Interval between runs of the users' backlog retention rules, 0 disables them", "minutes", "60");
+    cliParser->addOption("backlog-retention-batch", 0, "Max number of messages deleted at once when applying backlog retention rules", "count", "1000");
     cliParser->addOption("select-backend", 0, "Switch storage backend (migrating data if possible)", "backendidentifier");
     cliParser->addSwitch("add-user", 0, "Starts an interactive session to add a new core user");
     cliParser->addOption("change-userpass", 0, "Starts an interactive session to change the password of the user identified by <username>", "username");
@@ -221,26 +221,31 @@ IrcUser *Network::newIrcUser(const QString &hostmask, const QVariantMap &initDat
             ircuser->fromVariantMap(initData);
             ircuser->setInitialized();
         }
+        addNewIrcUser(nick, ircuser);
+    }
 
-        if (proxy())
-            proxy()->synchronize(ircuser);
-        else
-            qWarning() << "unable to synchronize new IrcUser" << hostmask << "forgot to call Network::setProxy(SignalProxy *)?";
+    return _ircUsers[nick];
+}
 
-        connect(ircuser, SIGNAL(nickSet(QString)), this, SLOT(ircUserNickChanged(QString)));
 
-        _ircUsers[nick] = ircuser;
+void Network::addNewIrcUser(const QString &nick, IrcUser *ircuser)
+{
+    if (proxy())
+        proxy()->synchronize(ircuser);
+    else
+        qWarning() << "unable to synchronize new IrcUser" << ircuser->hostmask() << "forgot to call Network::setProxy(SignalProxy *)?";
 
-        // This method will be called with a nick instead of hostmask by setInitIrcUsersAndChannels().
-        // Not a problem because initData contains all we need; however, making sure here to get the real
-        // hostmask out of the IrcUser afterwards.
-        QString mask = ircuser->hostmask();
-        SYNC_OTHER(addIrcUser, ARG(mask));
-        // emit ircUserAdded(mask);
-        emit ircUserAdded(ircuser);
-    }
+    connect(ircuser, SIGNAL(nickSet(QString)), this, SLOT(ircUserNickChanged(QString)));
 
-    return _ircUsers[nick];
+    _ircUsers[nick] = ircuser;
+
+    // IrcUsers created by initSetIrcUsersAndChannels() are constructed with a nick instead of hostmask.
+    // Not a problem because the init data contains all we need; however, making sure here to get the real
+    // hostmask out of the IrcUser afterwards.
+    QString mask = ircuser->hostmask();
+    SYNC_OTHER(addIrcUser, ARG(mask));
+    // emit ircUserAdded(mask);
+    emit ircUserAdded(ircuser);
 }
 
 
@@ -298,19 +303,24 @@ IrcChannel *Network::newIrcChannel(const QString &channelname, const QVariantMap
             channel->fromVariantMap(initData);
             channel->setInitialized();
         }
+        addNewIrcChannel(channelname, channel);
+    }
+    return _ircChannels[channelname.toLower()];
+}
+
 
-        if (proxy())
-            proxy()->synchronize(channel);
-        else
-            qWarning() << "unable to synchronize new IrcChannel" << channelname << "forgot to call Network::setProxy(SignalProxy *)?";
+void Network::addNewIrcChannel(const QString &channelname, IrcChannel *channel)
+{
+    if (proxy())
+        proxy()->synchronize(channel);
+    else
+        qWarning() << "unable to synchronize new IrcChannel" << channelname << "forgot to call Network::setProxy(SignalProxy *)?";
 
-        _ircChannels[channelname.toLower()] = channel;
+    _ircChannels[channelname.toLower()] = channel;
 
-        SYNC_OTHER(addIrcChannel, ARG(channelname))
-        // emit ircChannelAdded(channelname);
-        emit ircChannelAdded(channel);
-    }
-    return _ircChannels[channelname.toLower()];
+    SYNC_OTHER(addIrcChannel, ARG(channelname))
+    // emit ircChannelAdded(channelname);
+    emit ircChannelAdded(channel);
 }
 
 
@@ -699,47 +709,78 @@ QVariantMap Network::initSupports() const
 // where each list index corresponds to a particular IrcUser. This saves sending the key names a thousand times.
 // Benchmarks have shown space savings of around 56%, resulting in saving several MBs worth of data on sync
 // (without compression) with a decent amount of IrcUsers.
+// Users and channels are transferred column-wise, i.e. as a map from property name to a list holding that
+// property's value for all users (or channels). To keep the initial sync fast on large networks, the columns are
+// filled from the getters and applied through the setters directly, rather than building (and parsing) a variant
+// map per object via SyncableObject::toVariantMap(), which goes through the meta object for every single value.
+// Keep the keys in sync with the properties and init methods of IrcUser and IrcChannel!
+
 QVariantMap Network::initIrcUsersAndChannels() const
 {
     QVariantMap usersAndChannels;
 
     if (_ircUsers.count()) {
-        QHash<QString, QVariantList> users;
-        QHash<QString, IrcUser *>::const_iterator it = _ircUsers.begin();
-        QHash<QString, IrcUser *>::const_iterator end = _ircUsers.end();
-        while (it != end) {
-            const QVariantMap &map = it.value()->toVariantMap();
-            QVariantMap::const_iterator mapiter = map.begin();
-            while (mapiter != map.end()) {
-                users[mapiter.key()] << mapiter.value();
-                ++mapiter;
-            }
-            ++it;
+        QVariantList away, awayMessage, channels, encrypted, host, idleTime, ircOperator, lastAwayMessage,
+            loginTime, nick, realName, server, suserHost, user, userModes, whoisServiceReply;
+
+        foreach(IrcUser *ircUser, _ircUsers) {
+            away << ircUser->isAway();
+            awayMessage << ircUser->awayMessage();
+            channels << ircUser->channels();
+            encrypted << ircUser->encrypted();
+            host << ircUser->host();
+            idleTime << ircUser->idleTime();
+            ircOperator << ircUser->ircOperator();
+            lastAwayMessage << ircUser->lastAwayMessage();
+            loginTime << ircUser->loginTime();
+            nick << ircUser->nick();
+            realName << ircUser->realName();
+            server << ircUser->server();
+            suserHost << ircUser->suserHost();
+            user << ircUser->user();
+            userModes << ircUser->userModes();
+            whoisServiceReply << ircUser->whoisServiceReply();
         }
-        // Can't have a container with a value type != QVariant in a QVariant :(
-        // However, working directly on a QVariantMap is awkward for appending, thus the detour via the hash above.
+
         QVariantMap userMap;
-        foreach(const QString &key, users.keys())
-            userMap[key] = users[key];
+        userMap["away"] = away;
+        userMap["awayMessage"] = awayMessage;
+        userMap["channels"] = channels;
+        userMap["encrypted"] = encrypted;
+        userMap["host"] = host;
+        userMap["idleTime"] = idleTime;
+        userMap["ircOperator"] = ircOperator;
+        userMap["lastAwayMessage"] = lastAwayMessage;
+        userMap["loginTime"] = loginTime;
+        userMap["nick"] = nick;
+        userMap["realName"] = realName;
+        userMap["server"] = server;
+        userMap["suserHost"] = suserHost;
+        userMap["user"] = user;
+        userMap["userModes"] = userModes;
+        userMap["whoisServiceReply"] = whoisServiceReply;
         usersAndChannels["Users"] = userMap;
     }
 
     if (_ircChannels.count()) {
-        QHash<QString, QVariantList> channels;
-        QHash<QString, IrcChannel *>::const_iterator it = _ircChannels.begin();
-        QHash<QString, IrcChannel *>::const_iterator end = _ircChannels.end();
-        while (it != end) {
-            const QVariantMap &map = it.value()->toVariantMap();
-            QVariantMap::const_iterator mapiter = map.begin();
-            while (mapiter != map.end()) {
-                channels[mapiter.key()] << mapiter.value();
-                ++mapiter;
-            }
-            ++it;
+        QVariantList chanModes, userModes, encrypted, name, password, topic;
+
+        foreach(IrcChannel *channel, _ircChannels) {
+            chanModes << channel->initChanModes();
+            userModes << channel->initUserModes();
+            encrypted << channel->encrypted();
+            name << channel->name();
+            password << channel->password();
+            topic << channel->topic();
         }
+
         QVariantMap channelMap;
-        foreach(const QString &key, channels.keys())
-            channelMap[key] = channels[key];
+        channelMap["ChanModes"] = chanModes;
+        channelMap["UserModes"] = userModes;
+        channelMap["encrypted"] = encrypted;
+        channelMap["name"] = name;
+        channelMap["password"] = password;
+        channelMap["topic"] = topic;
         usersAndChannels["Channels"] = channelMap;
     }
 
@@ -769,12 +810,49 @@ void Network::initSetIrcUsersAndChannels(const QVariantMap &usersAndChannels)
         }
     }
 
+    // Columns may be missing if the other side is older (or newer) than us, so only apply the ones we got.
+    // The order of the setters matches the one SyncableObject::fromVariantMap() would use.
+    const QVariantList away = users["away"].toList();
+    const QVariantList awayMessage = users["awayMessage"].toList();
+    const QVariantList encrypted = users["encrypted"].toList();
+    const QVariantList host = users["host"].toList();
+    const QVariantList idleTime = users["idleTime"].toList();
+    const QVariantList ircOperator = users["ircOperator"].toList();
+    const QVariantList lastAwayMessage = users["lastAwayMessage"].toList();
+    const QVariantList loginTime = users["loginTime"].toList();
+    const QVariantList nick = users["nick"].toList();
+    const QVariantList realName = users["realName"].toList();
+    const QVariantList server = users["server"].toList();
+    const QVariantList suserHost = users["suserHost"].toList();
+    const QVariantList user = users["user"].toList();
+    const QVariantList userModes = users["userModes"].toList();
+    const QVariantList whoisServiceReply = users["whoisServiceReply"].toList();
+
     // now create the individual IrcUsers
     for(int i = 0; i < count; i++) {
-        QVariantMap map;
-        foreach(const QString &key, users.keys())
-            map[key] = users[key].toList().at(i);
-        newIrcUser(map["nick"].toString(), map); // newIrcUser() properly handles the hostmask being just the nick
+        QString nickName = nick.at(i).toString();
+        QString key = nickFromMask(nickName).toLower();
+        if (_ircUsers.contains(key))
+            continue;
+
+        IrcUser *ircUser = ircUserFactory(nickName);
+        if (!away.isEmpty()) ircUser->setAway(away.at(i).toBool());
+        if (!awayMessage.isEmpty()) ircUser->setAwayMessage(awayMessage.at(i).toString());
+        if (!encrypted.isEmpty()) ircUser->setEncrypted(encrypted.at(i).toBool());
+        if (!host.isEmpty()) ircUser->setHost(host.at(i).toString());
+        if (!idleTime.isEmpty()) ircUser->setIdleTime(idleTime.at(i).toDateTime());
+        if (!ircOperator.isEmpty()) ircUser->setIrcOperator(ircOperator.at(i).toString());
+        if (!lastAwayMessage.isEmpty()) ircUser->setLastAwayMessage(lastAwayMessage.at(i).toInt());
+        if (!loginTime.isEmpty()) ircUser->setLoginTime(loginTime.at(i).toDateTime());
+        ircUser->setNick(nickName);
+        if (!realName.isEmpty()) ircUser->setRealName(realName.at(i).toString());
+        if (!server.isEmpty()) ircUser->setServer(server.at(i).toString());
+        if (!suserHost.isEmpty()) ircUser->setSuserHost(suserHost.at(i).toString());
+        if (!user.isEmpty()) ircUser->setUser(user.at(i).toString());
+        if (!userModes.isEmpty()) ircUser->setUserModes(userModes.at(i).toString());
+        if (!whoisServiceReply.isEmpty()) ircUser->setWhoisServiceReply(whoisServiceReply.at(i).toString());
+        ircUser->setInitialized();
+        addNewIrcUser(key, ircUser);
     }
 
     // same thing for IrcChannels
@@ -788,12 +866,28 @@ void Network::initSetIrcUsersAndChannels(const QVariantMap &usersAndChannels)
             return;
         }
     }
+
+    const QVariantList chanModes = channels["ChanModes"].toList();
+    const QVariantList channelUserModes = channels["UserModes"].toList();
+    const QVariantList channelEncrypted = channels["encrypted"].toList();
+    const QVariantList name = channels["name"].toList();
+    const QVariantList password = channels["password"].toList();
+    const QVariantList topic = channels["topic"].toList();
+
     // now create the individual IrcChannels
     for(int i = 0; i < count; i++) {
-        QVariantMap map;
-        foreach(const QString &key, channels.keys())
-            map[key] = channels[key].toList().at(i);
-        newIrcChannel(map["name"].toString(), map);
+        QString channelName = name.at(i).toString();
+        if (_ircChannels.contains(channelName.toLower()))
+            continue;
+
+        IrcChannel *channel = ircChannelFactory(channelName);
+        if (!chanModes.isEmpty()) channel->initSetChanModes(chanModes.at(i).toMap());
+        if (!channelUserModes.isEmpty()) channel->initSetUserModes(channelUserModes.at(i).toMap());
+        if (!channelEncrypted.isEmpty()) channel->setEncrypted(channelEncrypted.at(i).toBool());
+        if (!password.isEmpty()) channel->setPassword(password.at(i).toString());
+        if (!topic.isEmpty()) channel->setTopic(topic.at(i).toString());
+        channel->setInitialized();
+        addNewIrcChannel(channelName, channel);
     }
 }
 
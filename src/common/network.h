@@ -321,6 +321,10 @@ protected:
     inline virtual IrcUser *ircUserFactory(const QString &hostmask) { return new IrcUser(hostmask, this); }
 
 private:
+    // shared by newIrcUser()/newIrcChannel() and initSetIrcUsersAndChannels() once the object's init data is set
+    void addNewIrcUser(const QString &nick, IrcUser *ircuser);
+    void addNewIrcChannel(const QString &channelname, IrcChannel *channel);
+
     QPointer<SignalProxy> _proxy;
 
     NetworkId _networkId;
@@ -27,6 +27,7 @@
 
 #include "authhandler.h"
 #include "protocol.h"
+#include "quassel.h"
 #include "signalproxy.h"
 
 class Peer : public QObject
@@ -44,6 +45,10 @@ public:
 
     AuthHandler *authHandler() const;
 
+    //! The runtime features supported by the other side of this connection
+    inline Quassel::Features features() const { return _features; }
+    inline void setFeatures(Quassel::Features features) { _features = features; }
+
     virtual bool isOpen() const = 0;
     virtual bool isSecure() const = 0;
     virtual bool isLocal() const = 0;
@@ -82,6 +87,7 @@ protected:
 
 private:
     QPointer<AuthHandler> _authHandler;
+    Quassel::Features _features;
 };
 
 // We need to special-case Peer* in attached signals/slots, so typedef it for the meta type system
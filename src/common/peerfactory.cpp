@@ -20,6 +20,7 @@
 
 #include "peerfactory.h"
 
+#include "protocols/compact/compactpeer.h"
 #include "protocols/datastream/datastreampeer.h"
 #include "protocols/legacy/legacypeer.h"
 
@@ -27,6 +28,7 @@
 PeerFactory::ProtoList PeerFactory::supportedProtocols()
 {
     ProtoList result;
+    result.append(ProtoDescriptor(Protocol::CompactProtocol, CompactPeer::supportedFeatures()));
     result.append(ProtoDescriptor(Protocol::DataStreamProtocol, DataStreamPeer::supportedFeatures()));
     result.append(ProtoDescriptor(Protocol::LegacyProtocol, 0));
     return result;
@@ -47,6 +49,10 @@ RemotePeer *PeerFactory::createPeer(const ProtoList &protocols, AuthHandler *aut
         switch(proto) {
             case Protocol::LegacyProtocol:
                 return new LegacyPeer(authHandler, socket, level, parent);
+            case Protocol::CompactProtocol:
+                if (CompactPeer::acceptsFeatures(features))
+                    return new CompactPeer(authHandler, socket, features, level, parent);
+                break;
             case Protocol::DataStreamProtocol:
                 if (DataStreamPeer::acceptsFeatures(features))
                     return new DataStreamPeer(authHandler, socket, features, level, parent);
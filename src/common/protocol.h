@@ -32,7 +32,8 @@ const quint32 magic = 0x42b33f00;
 enum Type {
     InternalProtocol = 0x00,
     LegacyProtocol = 0x01,
-    DataStreamProtocol = 0x02
+    DataStreamProtocol = 0x02,
+    CompactProtocol = 0x03
 };
 
 
@@ -57,16 +58,19 @@ struct HandshakeMessage {
 
 struct RegisterClient : public HandshakeMessage
 {
-    inline RegisterClient(const QString &clientVersion, const QString &buildDate, bool sslSupported = false)
+    inline RegisterClient(const QString &clientVersion, const QString &buildDate, bool sslSupported = false, quint32 clientFeatures = 0)
     : clientVersion(clientVersion)
     , buildDate(buildDate)
-    , sslSupported(sslSupported) {}
+    , sslSupported(sslSupported)
+    , clientFeatures(clientFeatures) {}
 
     QString clientVersion;
     QString buildDate;
 
     // this is only used by the LegacyProtocol in compat mode
     bool sslSupported;
+
+    quint32 clientFeatures;
 };
 
 
@@ -0,0 +1,332 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#include <QDataStream>
+#include <QMetaType>
+
+#include "compactpeer.h"
+
+using namespace Protocol;
+
+const quint16 nameDefinition = 0x8000; // the name follows and gets the id in the lower bits
+const quint16 literalName = 0x7fff;    // the name follows, but isn't interned as we ran out of ids
+
+enum ParamLayout {
+    FixedLayout = 1,  // values without type tags, as given by the signature
+    VariantLayout     // a plain QVariantList, for values that can't be streamed without their type
+};
+
+CompactPeer::CompactPeer(::AuthHandler *authHandler, QTcpSocket *socket, quint16 features, Compressor::CompressionLevel level, QObject *parent)
+    : DataStreamPeer(authHandler, socket, features, level, parent)
+{
+}
+
+
+// type names of the given parameters, separated by commas
+static QByteArray signature(const QVariantList &params)
+{
+    QByteArray result;
+    foreach(const QVariant &param, params) {
+        if (!result.isEmpty())
+            result += ',';
+        result += param.typeName();
+    }
+    return result;
+}
+
+
+static QByteArray serializeParams(const QVariantList &params)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_2);
+    stream << (quint8)FixedLayout;
+    foreach(const QVariant &param, params) {
+        if (!param.isValid() || !QMetaType::save(stream, param.userType(), param.constData())) {
+            QByteArray variantData;
+            QDataStream variantStream(&variantData, QIODevice::WriteOnly);
+            variantStream.setVersion(QDataStream::Qt_4_2);
+            variantStream << (quint8)VariantLayout << params;
+            return variantData;
+        }
+    }
+    return data;
+}
+
+
+void CompactPeer::writeName(QDataStream &stream, const QByteArray &name)
+{
+    QHash<QByteArray, quint16>::const_iterator it = _outgoingNames.constFind(name);
+    if (it != _outgoingNames.constEnd()) {
+        stream << it.value();
+        return;
+    }
+
+    if (_outgoingNames.count() >= literalName) {
+        stream << literalName << name;
+        return;
+    }
+
+    quint16 id = _outgoingNames.count();
+    _outgoingNames[name] = id;
+    stream << (quint16)(id | nameDefinition) << name;
+}
+
+
+bool CompactPeer::readName(QDataStream &stream, QByteArray &name)
+{
+    quint16 id;
+    stream >> id;
+
+    if (id == literalName) {
+        stream >> name;
+    }
+    else if (id & nameDefinition) {
+        // ids are handed out in order, anything else means we're out of sync
+        if ((id & ~nameDefinition) != _incomingNames.count())
+            return false;
+        stream >> name;
+        _incomingNames.append(name);
+    }
+    else {
+        if (id >= _incomingNames.count())
+            return false;
+        name = _incomingNames.at(id);
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+
+bool CompactPeer::readParams(QDataStream &stream, const QByteArray &signature, QVariantList &params)
+{
+    quint8 layout;
+    stream >> layout;
+
+    if (layout == VariantLayout) {
+        stream >> params;
+        return stream.status() == QDataStream::Ok;
+    }
+    if (layout != FixedLayout)
+        return false;
+
+    QHash<QByteArray, QVector<int> >::iterator typesIter = _signatureTypes.find(signature);
+    if (typesIter == _signatureTypes.end()) {
+        QVector<int> types;
+        if (!signature.isEmpty()) {
+            foreach(const QByteArray &typeName, signature.split(',')) {
+                int type = QMetaType::type(typeName.constData());
+                if (!type) {
+                    qWarning() << Q_FUNC_INFO << "Received parameter of unknown type" << typeName;
+                    return false;
+                }
+                types << type;
+            }
+        }
+        typesIter = _signatureTypes.insert(signature, types);
+    }
+
+    foreach(int type, typesIter.value()) {
+        QVariant param(type, (const void *)0);
+        if (!QMetaType::load(stream, type, param.data()))
+            return false;
+        params << param;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+
+void CompactPeer::processMessage(const QByteArray &msg)
+{
+    // the handshake is done using the DataStream protocol
+    if (!signalProxy()) {
+        DataStreamPeer::processMessage(msg);
+        return;
+    }
+
+    QDataStream stream(msg);
+    stream.setVersion(QDataStream::Qt_4_2);
+    quint8 requestType;
+    stream >> requestType;
+
+    switch (requestType) {
+        case Sync: {
+            QByteArray className, objectName, slotName, sig;
+            QVariantList params;
+            if (!readName(stream, className) || !readName(stream, objectName) || !readName(stream, slotName)
+                || !readName(stream, sig) || !readParams(stream, sig, params))
+                break;
+            handle(Protocol::SyncMessage(className, QString::fromUtf8(objectName), slotName, params));
+            return;
+        }
+        case RpcCall: {
+            QByteArray slotName, sig;
+            QVariantList params;
+            if (!readName(stream, slotName) || !readName(stream, sig) || !readParams(stream, sig, params))
+                break;
+            handle(Protocol::RpcCall(slotName, params));
+            return;
+        }
+        case InitRequest: {
+            QByteArray className, objectName;
+            if (!readName(stream, className) || !readName(stream, objectName))
+                break;
+            handle(Protocol::InitRequest(className, QString::fromUtf8(objectName)));
+            return;
+        }
+        case InitData: {
+            QByteArray className, objectName;
+            QVariantMap initData;
+            if (!readName(stream, className) || !readName(stream, objectName))
+                break;
+            stream >> initData;
+            if (stream.status() != QDataStream::Ok)
+                break;
+            handle(Protocol::InitData(className, QString::fromUtf8(objectName), initData));
+            return;
+        }
+        case HeartBeat:
+        case HeartBeatReply: {
+            QDateTime timestamp;
+            stream >> timestamp;
+            if (stream.status() != QDataStream::Ok)
+                break;
+            if (requestType == HeartBeat)
+                handle(Protocol::HeartBeat(timestamp));
+            else
+                handle(Protocol::HeartBeatReply(timestamp));
+            return;
+        }
+        default:
+            break;
+    }
+
+    close("Peer sent corrupt data, closing down!");
+}
+
+
+/*** Serialization ***/
+
+// The parts written by serialize() don't depend on the connection, so SignalProxy can share them between peers.
+// The names in front of them are interned per connection and thus written by dispatch().
+
+QByteArray CompactPeer::serialize(const Protocol::SyncMessage &msg) const
+{
+    return serializeParams(msg.params);
+}
+
+
+QByteArray CompactPeer::serialize(const Protocol::RpcCall &msg) const
+{
+    return serializeParams(msg.params);
+}
+
+
+QByteArray CompactPeer::serialize(const Protocol::InitRequest &msg) const
+{
+    Q_UNUSED(msg)
+    return QByteArray();
+}
+
+
+QByteArray CompactPeer::serialize(const Protocol::InitData &msg) const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_2);
+    stream << msg.initData;
+    return data;
+}
+
+
+void CompactPeer::dispatch(const Protocol::SyncMessage &msg)
+{
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_2);
+    stream << (quint8)Sync;
+    writeName(stream, msg.className);
+    writeName(stream, msg.objectName.toUtf8());
+    writeName(stream, msg.slotName);
+    writeName(stream, signature(msg.params));
+
+    RemotePeer::writeMessage(header, proxyPayload(msg));
+}
+
+
+void CompactPeer::dispatch(const Protocol::RpcCall &msg)
+{
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_2);
+    stream << (quint8)RpcCall;
+    writeName(stream, msg.slotName);
+    writeName(stream, signature(msg.params));
+
+    RemotePeer::writeMessage(header, proxyPayload(msg));
+}
+
+
+void CompactPeer::dispatch(const Protocol::InitRequest &msg)
+{
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_2);
+    stream << (quint8)InitRequest;
+    writeName(stream, msg.className);
+    writeName(stream, msg.objectName.toUtf8());
+
+    RemotePeer::writeMessage(header);
+}
+
+
+void CompactPeer::dispatch(const Protocol::InitData &msg)
+{
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_2);
+    stream << (quint8)InitData;
+    writeName(stream, msg.className);
+    writeName(stream, msg.objectName.toUtf8());
+
+    RemotePeer::writeMessage(header, proxyPayload(msg));
+}
+
+
+void CompactPeer::dispatch(const Protocol::HeartBeat &msg)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_2);
+    stream << (quint8)HeartBeat << msg.timestamp;
+
+    RemotePeer::writeMessage(data);
+}
+
+
+void CompactPeer::dispatch(const Protocol::HeartBeatReply &msg)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_2);
+    stream << (quint8)HeartBeatReply << msg.timestamp;
+
+    RemotePeer::writeMessage(data);
+}
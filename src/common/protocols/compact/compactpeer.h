@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#ifndef COMPACTPEER_H
+#define COMPACTPEER_H
+
+#include <QHash>
+#include <QVector>
+
+#include "../datastream/datastreampeer.h"
+
+//! A denser encoding of SignalProxy messages on top of the DataStream protocol
+/** The handshake is identical to the DataStream protocol. Afterwards, class, object and slot names are sent in full
+ *  only once per connection and referenced by a 16 bit id from then on. Parameters are stored without per-value type
+ *  tags; their types are given by a signature like "QString,int", which is interned like the names.
+ *  The parameter encoding doesn't depend on the connection, so it is still shared between peers.
+ */
+class CompactPeer : public DataStreamPeer
+{
+    Q_OBJECT
+
+public:
+    using DataStreamPeer::dispatch;
+
+    CompactPeer(AuthHandler *authHandler, QTcpSocket *socket, quint16 features, Compressor::CompressionLevel level, QObject *parent = 0);
+
+    Protocol::Type protocol() const { return Protocol::CompactProtocol; }
+    QString protocolName() const { return "the Compact protocol"; }
+
+    void dispatch(const Protocol::SyncMessage &msg);
+    void dispatch(const Protocol::RpcCall &msg);
+    void dispatch(const Protocol::InitRequest &msg);
+    void dispatch(const Protocol::InitData &msg);
+
+    void dispatch(const Protocol::HeartBeat &msg);
+    void dispatch(const Protocol::HeartBeatReply &msg);
+
+protected:
+    void processMessage(const QByteArray &msg);
+
+    QByteArray serialize(const Protocol::SyncMessage &msg) const;
+    QByteArray serialize(const Protocol::RpcCall &msg) const;
+    QByteArray serialize(const Protocol::InitRequest &msg) const;
+    QByteArray serialize(const Protocol::InitData &msg) const;
+
+private:
+    void writeName(QDataStream &stream, const QByteArray &name);
+    bool readName(QDataStream &stream, QByteArray &name);
+    bool readParams(QDataStream &stream, const QByteArray &signature, QVariantList &params);
+
+    QHash<QByteArray, quint16> _outgoingNames;
+    QVector<QByteArray> _incomingNames;
+    QHash<QByteArray, QVector<int> > _signatureTypes; // signature -> metatype ids
+};
+
+#endif
@@ -86,13 +86,19 @@ void DataStreamPeer::writeMessage(const QVariantMap &handshakeMsg)
 
 
 void DataStreamPeer::writeMessage(const QVariantList &sigProxyMsg)
+{
+    writeMessage(serializePackedFunc(sigProxyMsg));
+}
+
+
+QByteArray DataStreamPeer::serializePackedFunc(const QVariantList &packedFunc) const
 {
     QByteArray data;
     QDataStream msgStream(&data, QIODevice::WriteOnly);
     msgStream.setVersion(QDataStream::Qt_4_2);
-    msgStream << sigProxyMsg;
+    msgStream << packedFunc;
 
-    writeMessage(data);
+    return data;
 }
 
 
@@ -116,7 +122,7 @@ void DataStreamPeer::handleHandshakeMessage(const QVariantList &mapData)
     }
 
     if (msgType == "ClientInit") {
-        handle(RegisterClient(m["ClientVersion"].toString(), m["ClientDate"].toString(), false)); // UseSsl obsolete
+        handle(RegisterClient(m["ClientVersion"].toString(), m["ClientDate"].toString(), false, m["ClientFeatures"].toUInt())); // UseSsl obsolete
     }
 
     else if (msgType == "ClientInitReject") {
@@ -168,6 +174,7 @@ void DataStreamPeer::dispatch(const RegisterClient &msg) {
     m["MsgType"] = "ClientInit";
     m["ClientVersion"] = msg.clientVersion;
     m["ClientDate"] = msg.buildDate;
+    m["ClientFeatures"] = msg.clientFeatures;
 
     writeMessage(m);
 }
@@ -357,25 +364,25 @@ void DataStreamPeer::handlePackedFunc(const QVariantList &packedFunc)
 }
 
 
-void DataStreamPeer::dispatch(const Protocol::SyncMessage &msg)
+QByteArray DataStreamPeer::serialize(const Protocol::SyncMessage &msg) const
 {
-    dispatchPackedFunc(QVariantList() << (qint16)Sync << msg.className << msg.objectName.toUtf8() << msg.slotName << msg.params);
+    return serializePackedFunc(QVariantList() << (qint16)Sync << msg.className << msg.objectName.toUtf8() << msg.slotName << msg.params);
 }
 
 
-void DataStreamPeer::dispatch(const Protocol::RpcCall &msg)
+QByteArray DataStreamPeer::serialize(const Protocol::RpcCall &msg) const
 {
-    dispatchPackedFunc(QVariantList() << (qint16)RpcCall << msg.slotName << msg.params);
+    return serializePackedFunc(QVariantList() << (qint16)RpcCall << msg.slotName << msg.params);
 }
 
 
-void DataStreamPeer::dispatch(const Protocol::InitRequest &msg)
+QByteArray DataStreamPeer::serialize(const Protocol::InitRequest &msg) const
 {
-    dispatchPackedFunc(QVariantList() << (qint16)InitRequest << msg.className << msg.objectName.toUtf8());
+    return serializePackedFunc(QVariantList() << (qint16)InitRequest << msg.className << msg.objectName.toUtf8());
 }
 
 
-void DataStreamPeer::dispatch(const Protocol::InitData &msg)
+QByteArray DataStreamPeer::serialize(const Protocol::InitData &msg) const
 {
     QVariantList initData;
     QVariantMap::const_iterator it = msg.initData.begin();
@@ -383,7 +390,7 @@ void DataStreamPeer::dispatch(const Protocol::InitData &msg)
         initData << it.key().toUtf8() << it.value();
         ++it;
     }
-    dispatchPackedFunc(QVariantList() << (qint16)InitData << msg.className << msg.objectName.toUtf8() << initData);
+    return serializePackedFunc(QVariantList() << (qint16)InitData << msg.className << msg.objectName.toUtf8() << initData);
 }
 
 
@@ -39,6 +39,9 @@ public:
         HeartBeatReply
     };
 
+    // import the dispatch methods for SignalProxy messages from the baseclass
+    using RemotePeer::dispatch;
+
     DataStreamPeer(AuthHandler *authHandler, QTcpSocket *socket, quint16 features, Compressor::CompressionLevel level, QObject *parent = 0);
 
     Protocol::Type protocol() const { return Protocol::DataStreamProtocol; }
@@ -59,26 +62,29 @@ public:
     void dispatch(const Protocol::LoginSuccess &msg);
     void dispatch(const Protocol::SessionState &msg);
 
-    void dispatch(const Protocol::SyncMessage &msg);
-    void dispatch(const Protocol::RpcCall &msg);
-    void dispatch(const Protocol::InitRequest &msg);
-    void dispatch(const Protocol::InitData &msg);
-
     void dispatch(const Protocol::HeartBeat &msg);
     void dispatch(const Protocol::HeartBeatReply &msg);
 
 signals:
     void protocolError(const QString &errorString);
 
+protected:
+    void processMessage(const QByteArray &msg);
+
+    QByteArray serialize(const Protocol::SyncMessage &msg) const;
+    QByteArray serialize(const Protocol::RpcCall &msg) const;
+    QByteArray serialize(const Protocol::InitRequest &msg) const;
+    QByteArray serialize(const Protocol::InitData &msg) const;
+
 private:
     using RemotePeer::writeMessage;
     void writeMessage(const QVariantMap &handshakeMsg);
     void writeMessage(const QVariantList &sigProxyMsg);
-    void processMessage(const QByteArray &msg);
 
     void handleHandshakeMessage(const QVariantList &mapData);
     void handlePackedFunc(const QVariantList &packedFunc);
     void dispatchPackedFunc(const QVariantList &packedFunc);
+    QByteArray serializePackedFunc(const QVariantList &packedFunc) const;
 };
 
 #endif
@@ -97,6 +97,12 @@ void LegacyPeer::processMessage(const QByteArray &msg)
 
 
 void LegacyPeer::writeMessage(const QVariant &item)
+{
+    writeMessage(serializeItem(item));
+}
+
+
+QByteArray LegacyPeer::serializeItem(const QVariant &item) const
 {
     QByteArray block;
     QDataStream out(&block, QIODevice::WriteOnly);
@@ -116,7 +122,7 @@ void LegacyPeer::writeMessage(const QVariant &item)
         out << item;
     }
 
-    writeMessage(block);
+    return block;
 }
 
 
@@ -151,7 +157,7 @@ void LegacyPeer::handleHandshakeMessage(const QVariant &msg)
             socket()->setProperty("UseCompression", true);
         }
 #endif
-        handle(RegisterClient(m["ClientVersion"].toString(), m["ClientDate"].toString(), m["UseSsl"].toBool()));
+        handle(RegisterClient(m["ClientVersion"].toString(), m["ClientDate"].toString(), m["UseSsl"].toBool(), m["ClientFeatures"].toUInt()));
     }
 
     else if (msgType == "ClientInitReject") {
@@ -214,6 +220,7 @@ void LegacyPeer::dispatch(const RegisterClient &msg) {
     m["MsgType"] = "ClientInit";
     m["ClientVersion"] = msg.clientVersion;
     m["ClientDate"] = msg.buildDate;
+    m["ClientFeatures"] = msg.clientFeatures;
 
     // FIXME only in compat mode
     m["ProtocolVersion"] = protocolVersion;
@@ -428,34 +435,34 @@ void LegacyPeer::handlePackedFunc(const QVariant &packedFunc)
 }
 
 
-void LegacyPeer::dispatch(const Protocol::SyncMessage &msg)
+QByteArray LegacyPeer::serialize(const Protocol::SyncMessage &msg) const
 {
-    dispatchPackedFunc(QVariantList() << (qint16)Sync << msg.className << msg.objectName << msg.slotName << msg.params);
+    return serializeItem(QVariantList() << (qint16)Sync << msg.className << msg.objectName << msg.slotName << msg.params);
 }
 
 
-void LegacyPeer::dispatch(const Protocol::RpcCall &msg)
+QByteArray LegacyPeer::serialize(const Protocol::RpcCall &msg) const
 {
-    dispatchPackedFunc(QVariantList() << (qint16)RpcCall << msg.slotName << msg.params);
+    return serializeItem(QVariantList() << (qint16)RpcCall << msg.slotName << msg.params);
 }
 
 
-void LegacyPeer::dispatch(const Protocol::InitRequest &msg)
+QByteArray LegacyPeer::serialize(const Protocol::InitRequest &msg) const
 {
-    dispatchPackedFunc(QVariantList() << (qint16)InitRequest << msg.className << msg.objectName);
+    return serializeItem(QVariantList() << (qint16)InitRequest << msg.className << msg.objectName);
 }
 
 
-void LegacyPeer::dispatch(const Protocol::InitData &msg)
+QByteArray LegacyPeer::serialize(const Protocol::InitData &msg) const
 {
     // We need to special-case IrcUsersAndChannels, as the format changed
     if (msg.className == "Network") {
         QVariantMap initData = msg.initData;
         toLegacyIrcUsersAndChannels(initData);
-        dispatchPackedFunc(QVariantList() << (qint16)InitData << msg.className << msg.objectName << initData);
+        return serializeItem(QVariantList() << (qint16)InitData << msg.className << msg.objectName << initData);
     }
     else
-        dispatchPackedFunc(QVariantList() << (qint16)InitData << msg.className << msg.objectName << msg.initData);
+        return serializeItem(QVariantList() << (qint16)InitData << msg.className << msg.objectName << msg.initData);
 }
 
 
@@ -510,7 +517,7 @@ void LegacyPeer::fromLegacyIrcUsersAndChannels(QVariantMap &initData)
 }
 
 
-void LegacyPeer::toLegacyIrcUsersAndChannels(QVariantMap &initData)
+void LegacyPeer::toLegacyIrcUsersAndChannels(QVariantMap &initData) const
 {
     const QVariantMap &usersAndChannels = initData["IrcUsersAndChannels"].toMap();
     QVariantMap legacyMap;
@@ -37,6 +37,9 @@ public:
         HeartBeatReply
     };
 
+    // import the dispatch methods for SignalProxy messages from the baseclass
+    using RemotePeer::dispatch;
+
     LegacyPeer(AuthHandler *authHandler, QTcpSocket *socket, Compressor::CompressionLevel level, QObject *parent = 0);
 
     Protocol::Type protocol() const { return Protocol::LegacyProtocol; }
@@ -55,11 +58,6 @@ public:
     void dispatch(const Protocol::LoginSuccess &msg);
     void dispatch(const Protocol::SessionState &msg);
 
-    void dispatch(const Protocol::SyncMessage &msg);
-    void dispatch(const Protocol::RpcCall &msg);
-    void dispatch(const Protocol::InitRequest &msg);
-    void dispatch(const Protocol::InitData &msg);
-
     void dispatch(const Protocol::HeartBeat &msg);
     void dispatch(const Protocol::HeartBeatReply &msg);
 
@@ -69,16 +67,25 @@ signals:
     // only used in compat mode
     void protocolVersionMismatch(int actual, int expected);
 
+protected:
+    int wireFormat() const { return RemotePeer::wireFormat() | (_useCompression ? 1 << 24 : 0); }
+
+    QByteArray serialize(const Protocol::SyncMessage &msg) const;
+    QByteArray serialize(const Protocol::RpcCall &msg) const;
+    QByteArray serialize(const Protocol::InitRequest &msg) const;
+    QByteArray serialize(const Protocol::InitData &msg) const;
+
 private:
     using RemotePeer::writeMessage;
     void writeMessage(const QVariant &item);
+    QByteArray serializeItem(const QVariant &item) const;
     void processMessage(const QByteArray &msg);
 
     void handleHandshakeMessage(const QVariant &msg);
     void handlePackedFunc(const QVariant &packedFunc);
     void dispatchPackedFunc(const QVariantList &packedFunc);
 
-    void toLegacyIrcUsersAndChannels(QVariantMap &initData);
+    void toLegacyIrcUsersAndChannels(QVariantMap &initData) const;
     void fromLegacyIrcUsersAndChannels(QVariantMap &initData);
 
     bool _useCompression;
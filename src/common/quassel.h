@@ -72,8 +72,11 @@ public:
         SaslExternal = 0x0004,
         HideInactiveNetworks = 0x0008,
         PasswordChange = 0x0010,
+        BacklogStreaming = 0x0020,
+        DisplayMessages = 0x0040,
+        BacklogSearch = 0x0080,
 
-        NumFeatures = 0x0010
+        NumFeatures = 0x0080
     };
     Q_DECLARE_FLAGS(Features, Feature);
 
@@ -29,6 +29,7 @@
 #  include <QTcpSocket>
 #endif
 
+#include "quassel.h"
 #include "remotepeer.h"
 
 using namespace Protocol;
@@ -104,6 +105,7 @@ void RemotePeer::setSignalProxy(::SignalProxy *proxy)
         return;
 
     if (!proxy) {
+        _compressor->setWriteDelay(-1);
         _heartBeatTimer->stop();
         disconnect(signalProxy(), 0, this, 0);
         _signalProxy = 0;
@@ -116,6 +118,8 @@ void RemotePeer::setSignalProxy(::SignalProxy *proxy)
             return;
         }
         _signalProxy = proxy;
+        // the handshake is done, so we can start coalescing writes now (see --write-coalescing)
+        _compressor->setWriteDelay(Quassel::optionValue("write-coalescing").toInt());
         connect(proxy, SIGNAL(heartBeatIntervalChanged(int)), SLOT(changeHeartBeatInterval(int)));
         _heartBeatTimer->setInterval(proxy->heartBeatInterval() * 1000);
         _heartBeatTimer->start();
@@ -146,6 +150,22 @@ QTcpSocket *RemotePeer::socket() const
 }
 
 
+QVariantMap RemotePeer::transferStatistics() const
+{
+    const Compressor::Statistics &stats = _compressor->statistics();
+    QVariantMap result;
+    result["bytesIn"] = stats.bytesIn;
+    result["wireBytesIn"] = stats.wireBytesIn;
+    result["bytesOut"] = stats.bytesOut;
+    result["wireBytesOut"] = stats.wireBytesOut;
+    result["frames"] = stats.frames;
+    result["flushes"] = stats.flushes;
+    result["framesPerFlush"] = stats.flushes ? (double)stats.frames / stats.flushes : 0.0;
+    result["compressionRatio"] = stats.bytesOut ? (double)stats.wireBytesOut / stats.bytesOut : 1.0;
+    return result;
+}
+
+
 bool RemotePeer::isSecure() const
 {
     if (socket()) {
@@ -184,6 +204,7 @@ void RemotePeer::close(const QString &reason)
     }
 
     if (socket() && socket()->state() != QTcpSocket::UnconnectedState) {
+        _compressor->flush(); // don't lose writes that are held back for coalescing
         socket()->disconnectFromHost();
     }
 }
@@ -223,9 +244,9 @@ bool RemotePeer::readMessage(QByteArray &msg)
 
     emit transferProgress(_msgSize, _msgSize);
 
-    msg.resize(_msgSize);
-    qint64 bytesRead = _compressor->read(msg.data(), _msgSize);
-    if (bytesRead != _msgSize) {
+    // no need to copy; processMessage() is done with the data before we return to the event loop
+    msg = _compressor->readView(_msgSize);
+    if (msg.size() != (int)_msgSize) {
         close("Premature end of data stream!");
         return false;
     }
@@ -243,6 +264,46 @@ void RemotePeer::writeMessage(const QByteArray &msg)
 }
 
 
+void RemotePeer::writeMessage(const QByteArray &header, const QByteArray &body)
+{
+    quint32 size = qToBigEndian<quint32>(header.size() + body.size());
+    _compressor->write((const char*)&size, 4, Compressor::NoFlush);
+    _compressor->write(header.constData(), header.size(), Compressor::NoFlush);
+    _compressor->write(body.constData(), body.size());
+}
+
+
+template<typename T>
+void RemotePeer::writeProxyMessage(const T &msg)
+{
+    writeMessage(proxyPayload(msg));
+}
+
+
+void RemotePeer::dispatch(const SyncMessage &msg)
+{
+    writeProxyMessage(msg);
+}
+
+
+void RemotePeer::dispatch(const RpcCall &msg)
+{
+    writeProxyMessage(msg);
+}
+
+
+void RemotePeer::dispatch(const InitRequest &msg)
+{
+    writeProxyMessage(msg);
+}
+
+
+void RemotePeer::dispatch(const InitData &msg)
+{
+    writeProxyMessage(msg);
+}
+
+
 void RemotePeer::handle(const HeartBeat &heartBeat)
 {
     dispatch(HeartBeatReply(heartBeat.timestamp));
@@ -60,6 +60,15 @@ public:
 
     QTcpSocket *socket() const;
 
+    //! Transfer counters of this connection, suitable for showing in the UI
+    QVariantMap transferStatistics() const;
+
+    // SignalProxy messages are serialized once per wire format and shared between peers (see SignalProxy::cachedPayload())
+    void dispatch(const Protocol::SyncMessage &msg);
+    void dispatch(const Protocol::RpcCall &msg);
+    void dispatch(const Protocol::InitRequest &msg);
+    void dispatch(const Protocol::InitData &msg);
+
 public slots:
     void close(const QString &reason = QString());
 
@@ -72,8 +81,22 @@ protected:
     SignalProxy *signalProxy() const;
 
     void writeMessage(const QByteArray &msg);
+    //! Writes header and body as one message without joining them first; the header may be connection specific
+    void writeMessage(const QByteArray &header, const QByteArray &body);
     virtual void processMessage(const QByteArray &msg) = 0;
 
+    //! Serializes a SignalProxy message, or reuses what a peer with the same wire format serialized for it
+    template<typename T>
+    QByteArray proxyPayload(const T &msg);
+
+    //! Identifies the encoding of SignalProxy messages; peers returning the same value can share serialized messages
+    virtual int wireFormat() const { return protocol() | enabledFeatures() << 8; }
+
+    virtual QByteArray serialize(const Protocol::SyncMessage &msg) const = 0;
+    virtual QByteArray serialize(const Protocol::RpcCall &msg) const = 0;
+    virtual QByteArray serialize(const Protocol::InitRequest &msg) const = 0;
+    virtual QByteArray serialize(const Protocol::InitData &msg) const = 0;
+
     // These protocol messages get handled internally and won't reach SignalProxy
     void handle(const Protocol::HeartBeat &heartBeat);
     void handle(const Protocol::HeartBeatReply &heartBeatReply);
@@ -94,6 +117,9 @@ private slots:
 private:
     bool readMessage(QByteArray &msg);
 
+    template<typename T>
+    void writeProxyMessage(const T &msg);
+
 private:
     QTcpSocket *_socket;
     Compressor *_compressor;
@@ -104,4 +130,20 @@ private:
     quint32 _msgSize;
 };
 
+
+template<typename T>
+QByteArray RemotePeer::proxyPayload(const T &msg)
+{
+    QByteArray payload;
+    if (signalProxy())
+        payload = signalProxy()->cachedPayload(wireFormat());
+
+    if (payload.isNull()) {
+        payload = serialize(msg);
+        if (signalProxy())
+            signalProxy()->cachePayload(wireFormat(), payload);
+    }
+    return payload;
+}
+
 #endif
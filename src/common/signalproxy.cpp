@@ -228,6 +228,11 @@ void SignalProxy::init()
     setHeartBeatInterval(30);
     setMaxHeartBeatCount(2);
     _secure = false;
+    _restrictMessageTarget = false;
+    _cachePayloads = false;
+    _serializedMessageCount = 0;
+    _sharedMessageCount = 0;
+    _sharedBytes = 0;
     updateSecureState();
 }
 
@@ -506,12 +511,49 @@ void SignalProxy::stopSynchronize(SyncableObject *obj)
 template<class T>
 void SignalProxy::dispatch(const T &protoMessage)
 {
-    foreach (Peer *peer, _peers) {
+    const QSet<Peer *> &targets = _restrictMessageTarget ? _restrictedTargets : _peers;
+
+    // peers speaking the same protocol share the serialized message
+    QHash<int, QByteArray> previousCache;
+    previousCache.swap(_payloadCache);
+    bool previousCachePayloads = _cachePayloads;
+    _cachePayloads = targets.count() > 1;
+
+    foreach (Peer *peer, targets) {
+        if (_restrictMessageTarget && !_peers.contains(peer))
+            continue;
+
         if (peer->isOpen())
             peer->dispatch(protoMessage);
         else
             QCoreApplication::postEvent(this, new ::RemovePeerEvent(peer));
     }
+
+    _payloadCache.swap(previousCache);
+    _cachePayloads = previousCachePayloads;
+}
+
+
+QByteArray SignalProxy::cachedPayload(int wireFormat)
+{
+    if (!_cachePayloads)
+        return QByteArray();
+
+    QHash<int, QByteArray>::const_iterator iter = _payloadCache.constFind(wireFormat);
+    if (iter == _payloadCache.constEnd())
+        return QByteArray();
+
+    _sharedMessageCount++;
+    _sharedBytes += iter->size();
+    return iter.value();
+}
+
+
+void SignalProxy::cachePayload(int wireFormat, const QByteArray &payload)
+{
+    _serializedMessageCount++;
+    if (_cachePayloads)
+        _payloadCache.insert(wireFormat, payload);
 }
 
 
@@ -794,6 +836,8 @@ void SignalProxy::dumpProxyStats()
     qDebug() << "          attached Slots:" << _attachedSlots.count();
     qDebug() << " number of synced Slaves:" << slaveCount;
     qDebug() << "number of Classes cached:" << _extendedMetaObjects.count();
+    qDebug() << "     serialized messages:" << _serializedMessageCount;
+    qDebug() << "         shared messages:" << _sharedMessageCount << "(" << _sharedBytes << "bytes )";
 }
 
 
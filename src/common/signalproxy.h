@@ -78,6 +78,24 @@ public:
     void dumpProxyStats();
     void dumpSyncMap(SyncableObject *object);
     inline int peerCount() const { return _peers.size(); }
+    inline QSet<Peer *> peers() const { return _peers; }
+
+    //! Send everything emitted or synced while running function only to the given peers
+    /** This allows for sending different messages to peers with different feature sets.
+     *  Peers that are no longer connected to this proxy are skipped.
+     */
+    template<typename Function>
+    void restrictTargetPeers(const QSet<Peer *> &peers, Function function);
+
+    //! Return the payload another peer with the same wire format has serialized for the current dispatch
+    /** Only dispatching to several peers at once is cached; otherwise, a null QByteArray is returned.
+     */
+    QByteArray cachedPayload(int wireFormat);
+    void cachePayload(int wireFormat, const QByteArray &payload);
+
+    inline quint64 serializedMessageCount() const { return _serializedMessageCount; }
+    inline quint64 sharedMessageCount() const { return _sharedMessageCount; }
+    inline quint64 sharedBytes() const { return _sharedBytes; }
 
 public slots:
     void detachObject(QObject *obj);
@@ -162,12 +180,37 @@ private:
 
     bool _secure; // determines if all connections are in a secured state (using ssl or internal connections)
 
+    QSet<Peer *> _restrictedTargets;
+    bool _restrictMessageTarget;
+
+    // wire format -> serialized message, valid while dispatching to several peers
+    QHash<int, QByteArray> _payloadCache;
+    bool _cachePayloads;
+    quint64 _serializedMessageCount;
+    quint64 _sharedMessageCount;
+    quint64 _sharedBytes;
+
     friend class SignalRelay;
     friend class SyncableObject;
     friend class Peer;
 };
 
 
+template<typename Function>
+void SignalProxy::restrictTargetPeers(const QSet<Peer *> &peers, Function function)
+{
+    QSet<Peer *> previousTargets = _restrictedTargets;
+    bool previousRestrict = _restrictMessageTarget;
+    _restrictedTargets = peers;
+    _restrictMessageTarget = true;
+
+    function();
+
+    _restrictedTargets = previousTargets;
+    _restrictMessageTarget = previousRestrict;
+}
+
+
 // ==================================================
 //  ExtendedMetaObject
 // ==================================================
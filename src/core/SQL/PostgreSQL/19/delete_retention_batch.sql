@@ -0,0 +1,6 @@
+DELETE FROM backlog
+WHERE bufferid = :bufferid
+    AND (type & :types) != 0
+    AND messageid < :beforemsg
+    AND time < :before
+    AND messageid <= :lastmsg
\ No newline at end of file
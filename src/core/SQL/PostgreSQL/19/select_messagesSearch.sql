@@ -0,0 +1,9 @@
+SELECT messageid, bufferid, time,  type, flags, sender, message
+FROM backlog
+LEFT JOIN sender ON backlog.senderid = sender.senderid
+WHERE backlog.bufferid IN (SELECT bufferid FROM buffer WHERE userid = :userid)
+    AND (:allbuffers OR backlog.bufferid = :bufferid)
+    AND backlog.messageid < :beforemsg
+    AND to_tsvector('simple', message) @@ plainto_tsquery('simple', :query)
+ORDER BY messageid DESC
+LIMIT :limit
\ No newline at end of file
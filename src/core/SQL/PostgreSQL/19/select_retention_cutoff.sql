@@ -0,0 +1,6 @@
+SELECT messageid
+FROM backlog
+WHERE bufferid = :bufferid
+    AND (type & :types) != 0
+ORDER BY messageid DESC
+LIMIT 1 OFFSET :offset
\ No newline at end of file
@@ -0,0 +1,6 @@
+SELECT MAX(senderid), COUNT(*)
+FROM (SELECT senderid
+    FROM sender
+    WHERE senderid > :lastsender
+    ORDER BY senderid ASC
+    LIMIT :limit) AS batch
\ No newline at end of file
@@ -0,0 +1 @@
+CREATE INDEX backlog_message_search_idx ON backlog USING gin(to_tsvector('simple', message))
\ No newline at end of file
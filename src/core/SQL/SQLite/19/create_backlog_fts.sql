@@ -0,0 +1 @@
+CREATE VIRTUAL TABLE backlog_fts USING fts5(message, content = 'backlog', content_rowid = 'messageid')
\ No newline at end of file
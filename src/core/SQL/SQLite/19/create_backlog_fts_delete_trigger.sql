@@ -0,0 +1,3 @@
+CREATE TRIGGER backlog_fts_delete AFTER DELETE ON backlog BEGIN
+	INSERT INTO backlog_fts (backlog_fts, rowid, message) VALUES ('delete', old.messageid, old.message);
+END
\ No newline at end of file
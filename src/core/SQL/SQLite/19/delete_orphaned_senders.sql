@@ -0,0 +1,4 @@
+DELETE FROM sender
+WHERE senderid > :lastsender
+    AND senderid <= :maxsender
+    AND NOT EXISTS (SELECT 1 FROM backlog WHERE backlog.senderid = sender.senderid)
\ No newline at end of file
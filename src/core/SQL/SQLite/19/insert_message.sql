@@ -0,0 +1,2 @@
+INSERT INTO backlog (time, bufferid, type, flags, senderid, message)
+VALUES (:time, :bufferid, :type, :flags, :senderid, :message)
\ No newline at end of file
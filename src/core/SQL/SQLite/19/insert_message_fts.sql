@@ -0,0 +1 @@
+INSERT INTO backlog_fts (rowid, message) VALUES (:messageid, :message)
\ No newline at end of file
@@ -0,0 +1 @@
+SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'backlog_fts'
\ No newline at end of file
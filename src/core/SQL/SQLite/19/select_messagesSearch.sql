@@ -0,0 +1,10 @@
+SELECT backlog.messageid, backlog.bufferid, backlog.time, backlog.type, backlog.flags, sender.sender, backlog.message
+FROM backlog_fts
+JOIN backlog ON backlog.messageid = backlog_fts.rowid
+JOIN sender ON backlog.senderid = sender.senderid
+WHERE backlog_fts MATCH :query
+    AND backlog.bufferid IN (SELECT bufferid FROM buffer WHERE userid = :userid)
+    AND (:allbuffers OR backlog.bufferid = :bufferid)
+    AND backlog.messageid < :beforemsg
+ORDER BY backlog.messageid DESC
+LIMIT :limit
\ No newline at end of file
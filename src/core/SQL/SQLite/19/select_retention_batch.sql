@@ -0,0 +1,10 @@
+SELECT MAX(messageid), COUNT(*), SUM(LENGTH(message))
+FROM (SELECT messageid, message
+    FROM backlog
+    WHERE bufferid = :bufferid
+        AND bufferid IN (SELECT bufferid FROM buffer WHERE userid = :userid)
+        AND (type & :types) != 0
+        AND messageid < :beforemsg
+        AND time < :before
+    ORDER BY messageid ASC
+    LIMIT :limit) AS batch
\ No newline at end of file
@@ -0,0 +1,3 @@
+SELECT senderid
+FROM sender
+WHERE sender = :sender
\ No newline at end of file
@@ -32,7 +32,8 @@
 int AbstractSqlStorage::_nextConnectionId = 0;
 AbstractSqlStorage::AbstractSqlStorage(QObject *parent)
     : Storage(parent),
-    _schemaVersion(0)
+    _schemaVersion(0),
+    _senderCache(4 * 1024 * 1024) // max cost is measured in bytes
 {
 }
 
@@ -45,18 +46,38 @@ AbstractSqlStorage::~AbstractSqlStorage()
         QSqlDatabase::removeDatabase(conIter.value()->name());
         disconnect(conIter.value(), 0, this, 0);
     }
+    for (conIter = _readConnectionPool.begin(); conIter != _readConnectionPool.end(); ++conIter) {
+        QSqlDatabase::removeDatabase(conIter.value()->name());
+        disconnect(conIter.value(), 0, this, 0);
+    }
 }
 
 
 QSqlDatabase AbstractSqlStorage::logDb()
 {
-    if (!_connectionPool.contains(QThread::currentThread()))
-        addConnectionToPool();
+    return database(false);
+}
+
+
+QSqlDatabase AbstractSqlStorage::readDb()
+{
+    return database(useReadConnections());
+}
+
+
+QSqlDatabase AbstractSqlStorage::database(bool readOnly)
+{
+    QHash<QThread *, Connection *> &pool = readOnly ? _readConnectionPool : _connectionPool;
+    if (!pool.contains(QThread::currentThread()))
+        addConnectionToPool(readOnly);
 
-    QSqlDatabase db = QSqlDatabase::database(_connectionPool[QThread::currentThread()]->name(),false);
+    Connection *connection = pool[QThread::currentThread()];
+    QSqlDatabase db = QSqlDatabase::database(connection->name(), false);
 
     if (!db.isOpen()) {
         qWarning() << "Database connection" << displayName() << "for thread" << QThread::currentThread() << "was lost, attempting to reconnect...";
+        // prepared statements don't survive a reconnect
+        connection->clearPreparedQueries();
         dbConnect(db);
     }
 
@@ -64,24 +85,55 @@ QSqlDatabase AbstractSqlStorage::logDb()
 }
 
 
-void AbstractSqlStorage::addConnectionToPool()
+QSqlQuery AbstractSqlStorage::cachedQuery(const QString &queryName)
+{
+    return preparedQuery(queryName, false);
+}
+
+
+QSqlQuery AbstractSqlStorage::cachedReadQuery(const QString &queryName)
+{
+    return preparedQuery(queryName, useReadConnections());
+}
+
+
+QSqlQuery AbstractSqlStorage::preparedQuery(const QString &queryName, bool readOnly)
+{
+    QSqlDatabase db = database(readOnly);
+    Connection *connection = readOnly ? _readConnectionPool[QThread::currentThread()] : _connectionPool[QThread::currentThread()];
+    if (!connection->hasPreparedQuery(queryName)) {
+        QSqlQuery query(db);
+        if (!query.prepare(queryString(queryName))) {
+            // don't cache broken statements, so we retry next time
+            watchQuery(query);
+            return query;
+        }
+        connection->addPreparedQuery(queryName, query);
+    }
+    return connection->preparedQuery(queryName);
+}
+
+
+void AbstractSqlStorage::addConnectionToPool(bool readOnly)
 {
     QMutexLocker locker(&_connectionPoolMutex);
+    QHash<QThread *, Connection *> &pool = readOnly ? _readConnectionPool : _connectionPool;
     // we have to recheck if the connection pool already contains a connection for
     // this thread. Since now (after the lock) we can only tell for sure
-    if (_connectionPool.contains(QThread::currentThread()))
+    if (pool.contains(QThread::currentThread()))
         return;
 
     QThread *currentThread = QThread::currentThread();
 
     int connectionId = _nextConnectionId++;
 
-    Connection *connection = new Connection(QLatin1String(QString("quassel_%1_con_%2").arg(driverName()).arg(connectionId).toLatin1()));
+    QString connectionName = QString("quassel_%1_%2_%3").arg(driverName()).arg(readOnly ? "rocon" : "con").arg(connectionId);
+    Connection *connection = new Connection(QLatin1String(connectionName.toLatin1()));
     connection->moveToThread(currentThread);
     connect(this, SIGNAL(destroyed()), connection, SLOT(deleteLater()));
     connect(currentThread, SIGNAL(destroyed()), connection, SLOT(deleteLater()));
     connect(connection, SIGNAL(destroyed()), this, SLOT(connectionDestroyed()));
-    _connectionPool[currentThread] = connection;
+    pool[currentThread] = connection;
 
     QSqlDatabase db = QSqlDatabase::addDatabase(driverName(), connection->name());
     db.setDatabaseName(databaseName());
@@ -97,6 +149,9 @@ void AbstractSqlStorage::addConnectionToPool()
         db.setPassword(password());
     }
 
+    if (readOnly)
+        db.setConnectOptions(readConnectOptions());
+
     dbConnect(db);
 }
 
@@ -121,6 +176,7 @@ Storage::State AbstractSqlStorage::init(const QVariantMap &settings)
     setConnectionProperties(settings);
 
     _debug = Quassel::isOptionSet("debug");
+    loadQueries();
 
     QSqlDatabase db = logDb();
     if (!db.isValid() || !db.isOpen())
@@ -154,6 +210,21 @@ QString AbstractSqlStorage::queryString(const QString &queryName, int version)
     if (version == 0)
         version = schemaVersion();
 
+    if (version == schemaVersion() && !_queries.isEmpty()) {
+        QHash<QString, QString>::const_iterator iter = _queries.constFind(queryName);
+        if (iter == _queries.constEnd()) {
+            qCritical() << "Unable to read SQL-Query" << queryName << "for engine" << displayName();
+            return QString();
+        }
+        return iter.value();
+    }
+
+    return readQueryFile(queryName, version);
+}
+
+
+QString AbstractSqlStorage::readQueryFile(const QString &queryName, int version)
+{
     QFileInfo queryInfo(QString(":/SQL/%1/%2/%3.sql").arg(displayName()).arg(version).arg(queryName));
     if (!queryInfo.exists() || !queryInfo.isFile() || !queryInfo.isReadable()) {
         qCritical() << "Unable to read SQL-Query" << queryName << "for engine" << displayName();
@@ -170,6 +241,18 @@ QString AbstractSqlStorage::queryString(const QString &queryName, int version)
 }
 
 
+void AbstractSqlStorage::loadQueries()
+{
+    if (!_queries.isEmpty())
+        return;
+
+    QDir dir = QDir(QString(":/SQL/%1/%2/").arg(displayName()).arg(schemaVersion()));
+    foreach(QFileInfo fileInfo, dir.entryInfoList(QStringList() << "*.sql", QDir::Files, QDir::Name)) {
+        _queries[fileInfo.baseName()] = readQueryFile(fileInfo.baseName(), schemaVersion());
+    }
+}
+
+
 QStringList AbstractSqlStorage::setupQueries()
 {
     QStringList queries;
@@ -184,6 +267,7 @@ QStringList AbstractSqlStorage::setupQueries()
 bool AbstractSqlStorage::setup(const QVariantMap &settings)
 {
     setConnectionProperties(settings);
+    loadQueries();
     QSqlDatabase db = logDb();
     if (!db.isOpen()) {
         qCritical() << "Unable to setup Logging Backend!";
@@ -313,10 +397,41 @@ bool AbstractSqlStorage::watchQuery(QSqlQuery &query)
 }
 
 
+int AbstractSqlStorage::cachedSenderId(const QString &sender)
+{
+    QMutexLocker locker(&_senderCacheMutex);
+    int *senderId = _senderCache.object(sender);
+    return senderId ? *senderId : -1;
+}
+
+
+void AbstractSqlStorage::cacheSenderIds(const QHash<QString, int> &senderIds)
+{
+    QMutexLocker locker(&_senderCacheMutex);
+    QHash<QString, int>::const_iterator iter;
+    for (iter = senderIds.constBegin(); iter != senderIds.constEnd(); ++iter) {
+        // rough estimate of the memory used by one entry
+        int cost = iter.key().size() * sizeof(QChar) + 64;
+        _senderCache.insert(iter.key(), new int(iter.value()), cost);
+    }
+}
+
+
+void AbstractSqlStorage::clearSenderCache()
+{
+    QMutexLocker locker(&_senderCacheMutex);
+    _senderCache.clear();
+}
+
+
 void AbstractSqlStorage::connectionDestroyed()
 {
     QMutexLocker locker(&_connectionPoolMutex);
-    _connectionPool.remove(sender()->thread());
+    QThread *thread = sender()->thread();
+    if (_connectionPool.value(thread) == sender())
+        _connectionPool.remove(thread);
+    if (_readConnectionPool.value(thread) == sender())
+        _readConnectionPool.remove(thread);
 }
 
 
@@ -332,6 +447,8 @@ AbstractSqlStorage::Connection::Connection(const QString &name, QObject *parent)
 
 AbstractSqlStorage::Connection::~Connection()
 {
+    // the prepared queries have to go before their db connection
+    _preparedQueries.clear();
     {
         QSqlDatabase db = QSqlDatabase::database(name(), false);
         if (db.isOpen()) {
@@ -23,6 +23,7 @@
 
 #include "storage.h"
 
+#include <QCache>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
@@ -50,9 +51,26 @@ protected:
 
     QSqlDatabase logDb();
 
+    //! Returns the db connection to be used for long running reads (e.g. backlog requests)
+    /** If the backend supports it (see useReadConnections()), this is a separate read-only
+     *  connection for the current thread. Otherwise it's the same connection as logDb().
+     */
+    QSqlDatabase readDb();
+
     QString queryString(const QString &queryName, int version);
     inline QString queryString(const QString &queryName) { return queryString(queryName, 0); }
 
+    //! Returns a query prepared on the current thread's db connection
+    /** The query is prepared only once per connection and kept alive afterwards,
+     *  so callers only need to bind values and execute it. The returned object shares
+     *  its prepared statement with the cached one; call finish() on SELECT queries
+     *  when done reading.
+     */
+    QSqlQuery cachedQuery(const QString &queryName);
+
+    //! Same as cachedQuery(), but prepared on the connection returned by readDb()
+    QSqlQuery cachedReadQuery(const QString &queryName);
+
     QStringList setupQueries();
 
     QStringList upgradeQueries(int ver);
@@ -82,16 +100,51 @@ protected:
      */
     inline virtual bool initDbSession(QSqlDatabase & /* db */) { return true; }
 
+    //! Whether readDb() should hand out separate read-only connections
+    inline virtual bool useReadConnections() { return false; }
+
+    //! Connect options used for the read-only connections
+    inline virtual QString readConnectOptions() { return QString(); }
+
+    //! Look up a sender in the in-memory sender id cache
+    /** The cache is shared by all threads and bounded in size; least recently used
+     *  senders are evicted first.
+     *  \return The cached senderid, or -1 if the sender isn't cached
+     */
+    int cachedSenderId(const QString &sender);
+
+    //! Add committed sender ids to the cache
+    /** Only add ids that are known to exist in the db, i.e. after the transaction
+     *  that created them has been committed.
+     */
+    void cacheSenderIds(const QHash<QString, int> &senderIds);
+
+    //! Drop all cached sender ids. Call this whenever rows of the sender table may have been deleted.
+    void clearSenderCache();
+
 private slots:
     void connectionDestroyed();
 
 private:
-    void addConnectionToPool();
+    QSqlDatabase database(bool readOnly);
+    QSqlQuery preparedQuery(const QString &queryName, bool readOnly);
+    void addConnectionToPool(bool readOnly);
     void dbConnect(QSqlDatabase &db);
 
+    //! Read all queries of the current schema version into _queries
+    void loadQueries();
+    QString readQueryFile(const QString &queryName, int version);
+
     int _schemaVersion;
     bool _debug;
 
+    // query name -> query string for the current schema version. Filled once in init()/setup()
+    // and not modified afterwards, so it can be read from any thread without locking
+    QHash<QString, QString> _queries;
+
+    QMutex _senderCacheMutex;
+    QCache<QString, int> _senderCache;
+
     static int _nextConnectionId;
     QMutex _connectionPoolMutex;
     // we let a Connection Object manage each actual db connection
@@ -99,6 +152,7 @@ private:
     // which allows us thread safe termination of a connection
     class Connection;
     QHash<QThread *, Connection *> _connectionPool;
+    QHash<QThread *, Connection *> _readConnectionPool;
 };
 
 
@@ -115,8 +169,14 @@ public:
 
     inline QLatin1String name() const { return QLatin1String(_name); }
 
+    inline bool hasPreparedQuery(const QString &queryName) const { return _preparedQueries.contains(queryName); }
+    inline QSqlQuery preparedQuery(const QString &queryName) const { return _preparedQueries.value(queryName); }
+    inline void addPreparedQuery(const QString &queryName, const QSqlQuery &query) { _preparedQueries[queryName] = query; }
+    inline void clearPreparedQueries() { _preparedQueries.clear(); }
+
 private:
     QByteArray _name;
+    QHash<QString, QSqlQuery> _preparedQueries;
 };
 
 
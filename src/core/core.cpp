@@ -623,6 +623,9 @@ void Core::setupInternalClientSession(InternalPeer *clientPeer)
     InternalPeer *corePeer = new InternalPeer(this);
     corePeer->setPeer(clientPeer);
     clientPeer->setPeer(corePeer);
+    // client and core are built from the same sources, so they share all features
+    corePeer->setFeatures(Quassel::features());
+    clientPeer->setFeatures(Quassel::features());
 
     // Find or create session for validated user
     SessionThread *sessionThread = sessionForUser(uid);
@@ -373,6 +373,73 @@ public:
     }
 
 
+    //! Request the messages directly following a given message in its buffer
+    /** \param bufferId The buffer we request messages from
+     *  \param msgId    return only messages with a MsgId > msgId
+     *  \param limit    Max amount of messages
+     *  \return The requested list of messages, oldest first
+     */
+    static inline QList<Message> requestMsgsFollowing(UserId user, BufferId bufferId, MsgId msgId, int limit)
+    {
+        return instance()->_storage->requestMsgsFollowing(user, bufferId, msgId, limit);
+    }
+
+
+    //! Search the backlog for messages containing all words of a query
+    /** \param query    The words to look for
+     *  \param bufferId if valid, only search this buffer; otherwise, search all of the user's buffers
+     *  \param before   if != -1 return only messages with a MsgId < before
+     *  \param limit    Max amount of messages
+     *  \return The matching messages, newest first
+     */
+    static inline QList<Message> searchMsgs(UserId user, const QString &query, BufferId bufferId = BufferId(), MsgId before = -1, int limit = -1)
+    {
+        return instance()->_storage->searchMsgs(user, query, bufferId, before, limit);
+    }
+
+
+    //! Find the oldest message to keep when limiting a buffer to a number of messages
+    /** \param types  Only count messages of these types (ORed Message::Type values)
+     *  \param count  The number of messages to keep
+     *  \return The MsgId of the oldest message to keep, or an invalid MsgId if there are no more than count messages
+     */
+    static inline MsgId retentionCutoff(UserId user, BufferId bufferId, int types, int count)
+    {
+        return instance()->_storage->retentionCutoff(user, bufferId, types, count);
+    }
+
+
+    //! Delete a batch of the oldest messages of a buffer
+    /** \param before       if valid, delete only messages with a MsgId < before
+     *  \param olderThan    if valid, delete only messages older than this
+     *  \param limit        Max amount of messages to delete
+     *  \param deletedBytes Is set to the total size of the deleted message texts
+     *  \return The number of deleted messages, or -1 on error
+     */
+    static inline int deleteMsgs(UserId user, BufferId bufferId, int types, MsgId before, const QDateTime &olderThan, int limit, qint64 &deletedBytes)
+    {
+        return instance()->_storage->deleteMsgs(user, bufferId, types, before, olderThan, limit, deletedBytes);
+    }
+
+
+    //! Delete a batch of senders no longer referenced by any message
+    /** \param lastSenderId Start after this senderid; is advanced past the checked senders
+     *  \param deletedCount Is set to the number of deleted senders
+     *  \return false once all senders have been checked, or on error
+     */
+    static inline bool deleteOrphanedSenders(int &lastSenderId, int limit, int &deletedCount)
+    {
+        return instance()->_storage->deleteOrphanedSenders(lastSenderId, limit, deletedCount);
+    }
+
+
+    //! Space inside the database that can be reused, in bytes, or -1 if unknown
+    static inline qint64 reclaimableSpace()
+    {
+        return instance()->_storage->reclaimableSpace();
+    }
+
+
     //! Request a list of all buffers known to a user.
     /** This method is used to get a list of all buffers we have stored a backlog from.
      *  \note This method is threadsafe.
@@ -23,12 +23,16 @@
 #include "coresession.h"
 
 #include <QDebug>
+#include <QTimer>
 
 INIT_SYNCABLE_OBJECT(CoreBacklogManager)
 CoreBacklogManager::CoreBacklogManager(CoreSession *coreSession)
     : BacklogManager(coreSession),
-    _coreSession(coreSession)
+    _coreSession(coreSession),
+    _streamsScheduled(false)
 {
+    if (coreSession)
+        connect(coreSession->signalProxy(), SIGNAL(peerRemoved(Peer*)), SLOT(removePeer(Peer*)));
 }
 
 
@@ -115,3 +119,193 @@ QVariantList CoreBacklogManager::requestBacklogAll(MsgId first, MsgId last, int
 
     return backlog;
 }
+
+
+void CoreBacklogManager::requestBacklogStream(PeerPtr peer, BufferId bufferId, MsgId first, MsgId last, int limit, int additional)
+{
+    BacklogStream stream;
+    stream.peer = peer;
+    stream.bufferId = bufferId;
+    stream.first = first;
+    stream.last = last;
+    stream.remaining = limit;
+    stream.additional = limit != 0 ? additional : 0;
+    stream.additionalPhase = false;
+    _streams << stream;
+    scheduleStreams();
+}
+
+
+void CoreBacklogManager::requestBacklogAllStream(PeerPtr peer, MsgId first, MsgId last, int limit, int additional)
+{
+    BacklogStream stream;
+    stream.peer = peer;
+    stream.first = first;
+    stream.last = last;
+    stream.remaining = limit;
+    stream.additional = additional;
+    stream.additionalPhase = false;
+    _streams << stream;
+    scheduleStreams();
+}
+
+
+QVariantList CoreBacklogManager::requestBacklogSearch(const QString &query, BufferId bufferId, MsgId before, int limit, int context)
+{
+    if (limit < 0 || limit > maxSearchResults)
+        limit = maxSearchResults;
+    if (context < 0)
+        context = 0;
+    else if (context > maxSearchContext)
+        context = maxSearchContext;
+
+    QVariantList results;
+    QList<Message> matches = Core::searchMsgs(coreSession()->user(), query, bufferId, before, limit);
+    QList<Message>::const_iterator matchIter = matches.constBegin();
+    while (matchIter != matches.constEnd()) {
+        QVariantMap result;
+        result["Message"] = qVariantFromValue(*matchIter);
+
+        QVariantList contextBefore;
+        QVariantList contextAfter;
+        if (context > 0) {
+            BufferId matchBufferId = matchIter->bufferInfo().bufferId();
+            // requestMsgs() returns the newest messages first, but context is sent in chronological order
+            QList<Message> msgList = Core::requestMsgs(coreSession()->user(), matchBufferId, -1, matchIter->msgId(), context);
+            for (int i = msgList.count() - 1; i >= 0; i--)
+                contextBefore << qVariantFromValue(msgList.at(i));
+
+            msgList = Core::requestMsgsFollowing(coreSession()->user(), matchBufferId, matchIter->msgId(), context);
+            foreach(const Message &msg, msgList)
+                contextAfter << qVariantFromValue(msg);
+        }
+        result["Before"] = contextBefore;
+        result["After"] = contextAfter;
+
+        results << result;
+        ++matchIter;
+    }
+    return results;
+}
+
+
+void CoreBacklogManager::scheduleStreams()
+{
+    if (_streamsScheduled)
+        return;
+
+    // only send one chunk per stream and event loop iteration, so the sockets get the chance to flush in between
+    _streamsScheduled = true;
+    QTimer::singleShot(0, this, SLOT(processStreams()));
+}
+
+
+void CoreBacklogManager::processStreams()
+{
+    _streamsScheduled = false;
+
+    QList<BacklogStream>::iterator iter = _streams.begin();
+    while (iter != _streams.end()) {
+        if (sendNextChunk(*iter))
+            ++iter;
+        else
+            iter = _streams.erase(iter);
+    }
+
+    if (!_streams.isEmpty())
+        scheduleStreams();
+}
+
+
+bool CoreBacklogManager::sendNextChunk(BacklogStream &stream)
+{
+    int chunkLimit = streamChunkSize;
+    if (stream.remaining >= 0 && stream.remaining < chunkLimit)
+        chunkLimit = stream.remaining;
+
+    QList<Message> msgList;
+    if (chunkLimit > 0) {
+        if (stream.bufferId.isValid())
+            msgList = Core::requestMsgs(coreSession()->user(), stream.bufferId, stream.first, stream.last, chunkLimit);
+        else
+            msgList = Core::requestAllMsgs(coreSession()->user(), stream.first, stream.last, chunkLimit);
+    }
+
+    QVariantList chunk;
+    MsgId oldestInChunk;
+    QList<Message>::const_iterator msgIter = msgList.constBegin();
+    QList<Message>::const_iterator msgListEnd = msgList.constEnd();
+    while (msgIter != msgListEnd) {
+        chunk << qVariantFromValue(*msgIter);
+        if (!oldestInChunk.isValid() || msgIter->msgId() < oldestInChunk)
+            oldestInChunk = msgIter->msgId();
+        ++msgIter;
+    }
+    if (oldestInChunk.isValid() && (!stream.oldestSent.isValid() || oldestInChunk < stream.oldestSent))
+        stream.oldestSent = oldestInChunk;
+
+    if (stream.remaining > 0)
+        stream.remaining -= msgList.count();
+
+    // the messages are ordered newest first, so we page towards older messages
+    bool more = chunkLimit > 0 && msgList.count() == chunkLimit && stream.remaining != 0;
+    if (more)
+        stream.last = oldestInChunk;
+    else
+        more = startAdditionalPhase(stream);
+
+    bool complete = !more;
+    if (!chunk.isEmpty() || complete) {
+        PeerPtr peer = stream.peer;
+        if (stream.bufferId.isValid()) {
+            BufferId bufferId = stream.bufferId;
+            SYNC_OTHER(receiveBacklogChunk, ARG(peer), ARG(bufferId), ARG(chunk), ARG(complete))
+        }
+        else {
+            SYNC_OTHER(receiveBacklogAllChunk, ARG(peer), ARG(chunk), ARG(complete))
+        }
+    }
+    return more;
+}
+
+
+bool CoreBacklogManager::startAdditionalPhase(BacklogStream &stream)
+{
+    if (stream.additionalPhase || !stream.additional)
+        return false;
+
+    MsgId last;
+    if (stream.bufferId.isValid()) {
+        MsgId oldestMessage = stream.oldestSent.isValid() ? stream.oldestSent : stream.first;
+        last = stream.first != -1 ? stream.first : oldestMessage;
+
+        // only fetch additional messages if they continue seemlessly
+        // that is, if the list of messages is not truncated by the limit
+        if (last != oldestMessage)
+            return false;
+    }
+    else {
+        if (stream.first != -1)
+            last = stream.first;
+        else
+            last = stream.oldestSent.isValid() ? stream.oldestSent : MsgId(-1);
+    }
+
+    stream.first = -1;
+    stream.last = last;
+    stream.remaining = stream.additional;
+    stream.additionalPhase = true;
+    return true;
+}
+
+
+void CoreBacklogManager::removePeer(Peer *peer)
+{
+    QList<BacklogStream>::iterator iter = _streams.begin();
+    while (iter != _streams.end()) {
+        if (iter->peer == peer)
+            iter = _streams.erase(iter);
+        else
+            ++iter;
+    }
+}
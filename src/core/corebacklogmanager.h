@@ -35,12 +35,47 @@ public:
 
     CoreSession *coreSession() { return _coreSession; }
 
+    //! Number of messages sent per chunk when streaming backlog
+    static const int streamChunkSize = 500;
+    //! Max number of matches returned per requestBacklogSearch() call
+    static const int maxSearchResults = 100;
+    //! Max number of context messages returned before and after each match
+    static const int maxSearchContext = 10;
+
 public slots:
     virtual QVariantList requestBacklog(BufferId bufferId, MsgId first = -1, MsgId last = -1, int limit = -1, int additional = 0);
     virtual QVariantList requestBacklogAll(MsgId first = -1, MsgId last = -1, int limit = -1, int additional = 0);
 
+    virtual void requestBacklogStream(PeerPtr peer, BufferId bufferId, MsgId first, MsgId last, int limit, int additional);
+    virtual void requestBacklogAllStream(PeerPtr peer, MsgId first, MsgId last, int limit, int additional);
+
+    virtual QVariantList requestBacklogSearch(const QString &query, BufferId bufferId = BufferId(), MsgId before = -1, int limit = -1, int context = 0);
+
+private slots:
+    void processStreams();
+    void removePeer(Peer *peer);
+
 private:
+    struct BacklogStream {
+        PeerPtr peer;
+        BufferId bufferId; // invalid for requestBacklogAllStream()
+        MsgId first;
+        MsgId last;
+        int remaining; // -1 means unlimited
+        int additional;
+        bool additionalPhase;
+        MsgId oldestSent;
+    };
+
+    //! Fetch and send the next chunk of a stream. Returns false once the stream is finished.
+    bool sendNextChunk(BacklogStream &stream);
+    //! Set up the stream for the additional messages, as requestBacklog()/requestBacklogAll() do
+    bool startAdditionalPhase(BacklogStream &stream);
+    void scheduleStreams();
+
     CoreSession *_coreSession;
+    QList<BacklogStream> _streams;
+    bool _streamsScheduled;
 };
 
 
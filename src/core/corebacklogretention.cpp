@@ -0,0 +1,188 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#include "corebacklogretention.h"
+
+#include "core.h"
+#include "coresession.h"
+#include "logger.h"
+#include "quassel.h"
+
+CoreBacklogRetention::CoreBacklogRetention(CoreSession *coreSession)
+    : QObject(coreSession),
+    _coreSession(coreSession),
+    _batchSize(qMax(1, Quassel::optionValue("backlog-retention-batch").toInt())),
+    _running(false),
+    _sendersDone(false),
+    _lastSenderId(0),
+    _deletedMessages(0),
+    _deletedBytes(0),
+    _deletedSenders(0)
+{
+    int interval = Quassel::optionValue("backlog-retention-interval").toInt();
+    if (interval > 0) {
+        connect(&_timer, SIGNAL(timeout()), SLOT(start()));
+        _timer.start(interval * 60 * 1000);
+    }
+}
+
+
+void CoreBacklogRetention::start()
+{
+    if (_running)
+        return;
+
+    QList<QVariantMap> rules;
+    foreach(QVariant rule, Core::getUserSetting(_coreSession->user(), "BacklogRetention").toList()) {
+        QVariantMap ruleMap = rule.toMap();
+        if (ruleMap["MaxAge"].toInt() <= 0 && ruleMap["MaxCount"].toInt() <= 0)
+            continue;
+
+        // type specific rules go first, so they can't be starved by a general count rule
+        if (ruleMap.contains("Types"))
+            rules.prepend(ruleMap);
+        else
+            rules.append(ruleMap);
+    }
+    if (rules.isEmpty())
+        return;
+
+    QList<BufferInfo> buffers = Core::requestBuffers(_coreSession->user());
+    QDateTime now = QDateTime::currentDateTime();
+
+    _jobs.clear();
+    foreach(QVariantMap rule, rules) {
+        NetworkId networkId = rule["NetworkId"].toInt();
+        BufferId bufferId = rule["BufferId"].toInt();
+        int types = rule.value("Types", -1).toInt();
+        int maxAge = rule["MaxAge"].toInt();
+        int maxCount = rule["MaxCount"].toInt();
+
+        foreach(BufferInfo bufferInfo, buffers) {
+            if (networkId.isValid() && bufferInfo.networkId() != networkId)
+                continue;
+            if (bufferId.isValid() && bufferInfo.bufferId() != bufferId)
+                continue;
+
+            // age and count limits are separate jobs, as a message exceeding either one has to go
+            Job job;
+            job.bufferId = bufferInfo.bufferId();
+            job.types = types;
+            job.maxCount = 0;
+            if (maxAge > 0) {
+                job.olderThan = now.addDays(-maxAge);
+                _jobs << job;
+            }
+            if (maxCount > 0) {
+                job.olderThan = QDateTime();
+                job.maxCount = maxCount;
+                _jobs << job;
+            }
+        }
+    }
+
+    _running = true;
+    _sendersDone = false;
+    _lastSenderId = 0;
+    _deletedMessages = 0;
+    _deletedBytes = 0;
+    _deletedSenders = 0;
+    _startTime = now;
+    scheduleBatch();
+}
+
+
+void CoreBacklogRetention::scheduleBatch()
+{
+    // go through the event loop between batches, so the session keeps processing IRC traffic
+    QTimer::singleShot(0, this, SLOT(processBatch()));
+}
+
+
+void CoreBacklogRetention::processBatch()
+{
+    if (!_jobs.isEmpty()) {
+        Job &job = _jobs.first();
+        UserId user = _coreSession->user();
+
+        if (job.maxCount > 0 && !job.before.isValid()) {
+            // determine the cutoff only now, so that jobs processed earlier are already accounted for
+            job.before = Core::retentionCutoff(user, job.bufferId, job.types, job.maxCount);
+            if (!job.before.isValid()) {
+                _jobs.removeFirst();
+                scheduleBatch();
+                return;
+            }
+        }
+
+        qint64 bytes = 0;
+        int deleted = Core::deleteMsgs(user, job.bufferId, job.types, job.before, job.olderThan, _batchSize, bytes);
+        if (deleted < 0) {
+            qWarning() << "CoreBacklogRetention: could not delete backlog of buffer" << job.bufferId.toInt();
+            _jobs.removeFirst();
+        }
+        else {
+            _deletedMessages += deleted;
+            _deletedBytes += bytes;
+            if (deleted < _batchSize)
+                _jobs.removeFirst();
+        }
+        scheduleBatch();
+        return;
+    }
+
+    // senders are shared between users, so only bother if we actually deleted something
+    if (!_sendersDone && _deletedMessages > 0) {
+        int deleted = 0;
+        _sendersDone = !Core::deleteOrphanedSenders(_lastSenderId, _batchSize, deleted);
+        _deletedSenders += deleted;
+        if (!_sendersDone) {
+            scheduleBatch();
+            return;
+        }
+    }
+
+    finish();
+}
+
+
+void CoreBacklogRetention::finish()
+{
+    _running = false;
+
+    qint64 reclaimable = Core::reclaimableSpace();
+
+    _report.clear();
+    _report["LastRun"] = _startTime;
+    _report["Duration"] = _startTime.msecsTo(QDateTime::currentDateTime());
+    _report["DeletedMessages"] = _deletedMessages;
+    _report["DeletedBytes"] = _deletedBytes;
+    _report["DeletedSenders"] = _deletedSenders;
+    _report["ReclaimableSpace"] = reclaimable;
+
+    if (_deletedMessages > 0) {
+        quInfo() << qPrintable(QString("Backlog retention for user %1: deleted %2 messages (%3 bytes of text) and %4 senders%5")
+                               .arg(_coreSession->user().toInt())
+                               .arg(_deletedMessages)
+                               .arg(_deletedBytes)
+                               .arg(_deletedSenders)
+                               .arg(reclaimable >= 0 ? QString(", %1 bytes reclaimable").arg(reclaimable) : QString()));
+    }
+}
@@ -0,0 +1,93 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#ifndef COREBACKLOGRETENTION_H
+#define COREBACKLOGRETENTION_H
+
+#include <QDateTime>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <QVariantMap>
+
+#include "types.h"
+
+class CoreSession;
+
+//! Prunes old backlog according to the user's retention rules
+/** Rules are stored in the user setting "BacklogRetention" as a list of maps with the keys
+ *  NetworkId and BufferId (restrict the rule; unset or 0 matches all), MaxAge (days), MaxCount
+ *  (messages per buffer) and Types (ORed Message::Type values; unset matches all types).
+ *  Rules restricted to some message types are applied first, so e.g. joins, parts and quits
+ *  can be pruned more aggressively than regular messages.
+ *
+ *  Deletion runs in bounded batches, each one scheduled through the event loop, so a run
+ *  never blocks the session for long. Once all buffers are done, senders no longer referenced
+ *  by any message are removed as well.
+ */
+class CoreBacklogRetention : public QObject
+{
+    Q_OBJECT
+
+public:
+    CoreBacklogRetention(CoreSession *coreSession);
+
+    inline bool isRunning() const { return _running; }
+
+    //! Statistics of the last completed run, empty if there was none yet
+    inline QVariantMap report() const { return _report; }
+
+public slots:
+    //! Start a retention run, unless one is already in progress
+    void start();
+
+private slots:
+    void processBatch();
+
+private:
+    struct Job {
+        BufferId bufferId;
+        int types;
+        int maxCount;
+        MsgId before;
+        QDateTime olderThan;
+    };
+
+    void scheduleBatch();
+    void finish();
+
+    CoreSession *_coreSession;
+    QTimer _timer;
+    int _batchSize;
+
+    bool _running;
+    QList<Job> _jobs;
+    bool _sendersDone;
+    int _lastSenderId;
+
+    qint64 _deletedMessages;
+    qint64 _deletedBytes;
+    int _deletedSenders;
+    QDateTime _startTime;
+    QVariantMap _report;
+};
+
+
+#endif //COREBACKLOGRETENTION_H
@@ -101,8 +101,10 @@ void CoreBufferSyncer::removeBuffer(BufferId bufferId)
             return;
         }
     }
-    if (Core::removeBuffer(_coreSession->user(), bufferId))
+    if (Core::removeBuffer(_coreSession->user(), bufferId)) {
+        _coreSession->invalidateBufferInfo(bufferId);
         BufferSyncer::removeBuffer(bufferId);
+    }
 }
 
 
@@ -119,8 +121,10 @@ void CoreBufferSyncer::renameBuffer(BufferId bufferId, QString newName)
         return;
     }
 
-    if (Core::renameBuffer(_coreSession->user(), bufferId, newName))
+    if (Core::renameBuffer(_coreSession->user(), bufferId, newName)) {
+        _coreSession->invalidateBufferInfo(bufferId);
         BufferSyncer::renameBuffer(bufferId, newName);
+    }
 }
 
 
@@ -139,6 +143,8 @@ void CoreBufferSyncer::mergeBuffersPermanently(BufferId bufferId1, BufferId buff
     }
 
     if (Core::mergeBuffersPermanently(_coreSession->user(), bufferId1, bufferId2)) {
+        _coreSession->invalidateBufferInfo(bufferId1);
+        _coreSession->invalidateBufferInfo(bufferId2);
         BufferSyncer::mergeBuffersPermanently(bufferId1, bufferId2);
     }
 }
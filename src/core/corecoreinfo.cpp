@@ -21,8 +21,12 @@
 #include "corecoreinfo.h"
 
 #include "core.h"
+#include "corebacklogretention.h"
 #include "coresession.h"
+#include "event.h"
+#include "eventmanager.h"
 #include "quassel.h"
+#include "remotepeer.h"
 #include "signalproxy.h"
 
 INIT_SYNCABLE_OBJECT(CoreCoreInfo)
@@ -40,5 +44,26 @@ QVariantMap CoreCoreInfo::coreData() const
     data["quasselBuildDate"] = Quassel::buildInfo().buildDate;
     data["startTime"] = Core::instance()->startTime();
     data["sessionConnectedClients"] = _coreSession->signalProxy()->peerCount();
+    QVariantList traffic;
+    foreach(Peer *peer, _coreSession->signalProxy()->peers()) {
+        RemotePeer *remotePeer = qobject_cast<RemotePeer *>(peer);
+        if (!remotePeer)
+            continue;
+        QVariantMap peerData = remotePeer->transferStatistics();
+        peerData["peer"] = remotePeer->description();
+        traffic << peerData;
+    }
+    if (!traffic.isEmpty())
+        data["sessionClientTraffic"] = traffic;
+    data["sessionEventDispatch"] = _coreSession->eventManager()->dispatchStats();
+    quint64 allocations, heapAllocations;
+    Event::allocationStats(allocations, heapAllocations);
+    QVariantMap eventAllocations;
+    eventAllocations["allocations"] = allocations;
+    eventAllocations["heapAllocations"] = heapAllocations;
+    data["eventAllocations"] = eventAllocations;
+    QVariantMap retention = _coreSession->backlogRetention()->report();
+    if (!retention.isEmpty())
+        data["backlogRetention"] = retention;
     return data;
 }
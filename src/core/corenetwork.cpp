@@ -79,6 +79,7 @@ CoreNetwork::CoreNetwork(const NetworkId &networkid, CoreSession *session)
     connect(&socket, SIGNAL(sslErrors(const QList<QSslError> &)), this, SLOT(sslErrors(const QList<QSslError> &)));
 #endif
     connect(this, SIGNAL(newEvent(Event *)), coreSession()->eventManager(), SLOT(postEvent(Event *)));
+    connect(this, SIGNAL(newEvents(const QList<Event *> &)), coreSession()->eventManager(), SLOT(postEvents(const QList<Event *> &)));
 
     if (Quassel::isOptionSet("oidentd")) {
         connect(this, SIGNAL(socketInitialized(const CoreIdentity*, QHostAddress, quint16, QHostAddress, quint16)), Core::instance()->oidentdConfigGenerator(), SLOT(addSocket(const CoreIdentity*, QHostAddress, quint16, QHostAddress, quint16)), Qt::BlockingQueuedConnection);
@@ -185,6 +186,9 @@ void CoreNetwork::connectToIrc(bool reconnecting)
 
     enablePingTimeout();
 
+    // don't let a partial line from the previous connection end up in front of the new one
+    _readBuffer.clear();
+
     // Qt caches DNS entries for a minute, resulting in round-robin (e.g. for chat.freenode.net) not working if several users
     // connect at a similar time. QHostInfo::fromName(), however, always performs a fresh lookup, overwriting the cache entry.
     QHostInfo::fromName(server.host);
@@ -419,16 +423,26 @@ void CoreNetwork::setMyNick(const QString &mynick)
 
 void CoreNetwork::socketHasData()
 {
-    while (socket.canReadLine()) {
-        QByteArray s = socket.readLine();
-        if (s.endsWith("\r\n"))
-            s.chop(2);
-        else if (s.endsWith("\n"))
-            s.chop(1);
-        NetworkDataEvent *event = new NetworkDataEvent(EventManager::NetworkIncoming, this, s);
-        event->setTimestamp(QDateTime::currentDateTimeUtc());
-        emit newEvent(event);
+    // read everything that's available at once, and hand all complete lines to the event manager as one batch
+    _readBuffer.append(socket.readAll());
+
+    QList<Event *> events;
+    QDateTime timestamp = QDateTime::currentDateTimeUtc();
+    const char *data = _readBuffer.constData();
+    int start = 0;
+    int end;
+    while ((end = _readBuffer.indexOf('\n', start)) >= 0) {
+        int length = end - start;
+        if (length > 0 && data[end - 1] == '\r')
+            length--;
+        NetworkDataEvent *event = new NetworkDataEvent(EventManager::NetworkIncoming, this, QByteArray(data + start, length));
+        event->setTimestamp(timestamp);
+        events << event;
+        start = end + 1;
     }
+    _readBuffer.remove(0, start);
+
+    emit newEvents(events);
 }
 
 
@@ -165,6 +165,7 @@ signals:
     void sslErrors(const QVariant &errorData);
 
     void newEvent(Event *event);
+    void newEvents(const QList<Event *> &events);
     void socketInitialized(const CoreIdentity *identity, const QHostAddress &localAddress, quint16 localPort, const QHostAddress &peerAddress, quint16 peerPort);
     void socketDisconnected(const CoreIdentity *identity, const QHostAddress &localAddress, quint16 localPort, const QHostAddress &peerAddress, quint16 peerPort);
 
@@ -213,6 +214,8 @@ private:
     QTcpSocket socket;
 #endif
 
+    QByteArray _readBuffer; // holds an incomplete line until the rest arrives
+
     CoreUserInputHandler *_userInputHandler;
 
     QHash<QString, QString> _channelKeys; // stores persistent channels and their passwords, if any
@@ -26,6 +26,7 @@
 #include "coreuserinputhandler.h"
 #include "corebuffersyncer.h"
 #include "corebacklogmanager.h"
+#include "corebacklogretention.h"
 #include "corebufferviewmanager.h"
 #include "coreeventmanager.h"
 #include "coreidentity.h"
@@ -44,6 +45,7 @@
 #include "ircuser.h"
 #include "logger.h"
 #include "messageevent.h"
+#include "quassel.h"
 #include "remotepeer.h"
 #include "storage.h"
 #include "util.h"
@@ -63,6 +65,7 @@ CoreSession::CoreSession(UserId uid, bool restoreState, QObject *parent)
     _aliasManager(this),
     _bufferSyncer(new CoreBufferSyncer(this)),
     _backlogManager(new CoreBacklogManager(this)),
+    _backlogRetention(new CoreBacklogRetention(this)),
     _bufferViewManager(new CoreBufferViewManager(_signalProxy, this)),
     _ircListHelper(new CoreIrcListHelper(this)),
     _networkConfig(new CoreNetworkConfig("GlobalNetworkConfig", this)),
@@ -88,6 +91,7 @@ CoreSession::CoreSession(UserId uid, bool restoreState, QObject *parent)
 
     p->attachSlot(SIGNAL(sendInput(BufferInfo, QString)), this, SLOT(msgFromClient(BufferInfo, QString)));
     p->attachSignal(this, SIGNAL(displayMsg(Message)));
+    p->attachSignal(this, SIGNAL(displayMessages(QVariantList)));
     p->attachSignal(this, SIGNAL(displayStatusMsg(QString, QString)));
 
     p->attachSignal(this, SIGNAL(identityCreated(const Identity &)));
@@ -136,6 +140,8 @@ CoreSession::CoreSession(UserId uid, bool restoreState, QObject *parent)
 
 CoreSession::~CoreSession()
 {
+    if (Quassel::isOptionSet("debug"))
+        _eventManager->dumpDispatchStats();
     saveSessionState();
     foreach(CoreNetwork *net, _networks.values()) {
         delete net;
@@ -318,10 +324,10 @@ void CoreSession::processMessages()
     if (_messageQueue.count() == 1) {
         const RawMessage &rawMsg = _messageQueue.first();
         bool createBuffer = !(rawMsg.flags & Message::Redirected);
-        BufferInfo bufferInfo = Core::bufferInfo(user(), rawMsg.networkId, rawMsg.bufferType, rawMsg.target, createBuffer);
+        BufferInfo bufferInfo = this->bufferInfo(rawMsg.networkId, rawMsg.bufferType, rawMsg.target, createBuffer);
         if (!bufferInfo.isValid()) {
             Q_ASSERT(!createBuffer);
-            bufferInfo = Core::bufferInfo(user(), rawMsg.networkId, BufferInfo::StatusBuffer, "");
+            bufferInfo = this->bufferInfo(rawMsg.networkId, BufferInfo::StatusBuffer, "");
         }
         Message msg(bufferInfo, rawMsg.type, rawMsg.text, rawMsg.sender, rawMsg.flags);
         if(Core::storeMessage(msg))
@@ -339,7 +345,7 @@ void CoreSession::processMessages()
             }
             else {
                 bool createBuffer = !(rawMsg.flags & Message::Redirected);
-                bufferInfo = Core::bufferInfo(user(), rawMsg.networkId, rawMsg.bufferType, rawMsg.target, createBuffer);
+                bufferInfo = this->bufferInfo(rawMsg.networkId, rawMsg.bufferType, rawMsg.target, createBuffer);
                 if (!bufferInfo.isValid()) {
                     Q_ASSERT(!createBuffer);
                     redirectedMessages << rawMsg;
@@ -359,7 +365,7 @@ void CoreSession::processMessages()
             }
             else {
                 // no luck -> we store them in the StatusBuffer
-                bufferInfo = Core::bufferInfo(user(), rawMsg.networkId, BufferInfo::StatusBuffer, "");
+                bufferInfo = this->bufferInfo(rawMsg.networkId, BufferInfo::StatusBuffer, "");
                 // add the StatusBuffer to the Cache in case there are more Messages for the original target
                 bufferInfoCache[rawMsg.networkId][rawMsg.target] = bufferInfo;
             }
@@ -368,9 +374,31 @@ void CoreSession::processMessages()
         }
 
         if(Core::storeMessages(messages)) {
-            // FIXME: extend protocol to a displayMessages(MessageList)
-            for (int i = 0; i < messages.count(); i++) {
-                emit displayMsg(messages[i]);
+            // clients knowing about displayMessages() get the whole batch in one go
+            QSet<Peer *> batchPeers;
+            QSet<Peer *> legacyPeers;
+            foreach(Peer *peer, signalProxy()->peers()) {
+                if (peer->features() & Quassel::DisplayMessages)
+                    batchPeers.insert(peer);
+                else
+                    legacyPeers.insert(peer);
+            }
+
+            if (!batchPeers.isEmpty()) {
+                QVariantList msgList;
+                for (int i = 0; i < messages.count(); i++)
+                    msgList << QVariant::fromValue<Message>(messages[i]);
+                signalProxy()->restrictTargetPeers(batchPeers, [&] {
+                    emit displayMessages(msgList);
+                });
+            }
+
+            if (!legacyPeers.isEmpty()) {
+                signalProxy()->restrictTargetPeers(legacyPeers, [&] {
+                    for (int i = 0; i < messages.count(); i++) {
+                        emit displayMsg(messages[i]);
+                    }
+                });
             }
         }
     }
@@ -379,6 +407,37 @@ void CoreSession::processMessages()
 }
 
 
+BufferInfo CoreSession::bufferInfo(NetworkId networkId, BufferInfo::Type type, const QString &bufferName, bool create)
+{
+    QHash<QPair<int, QString>, BufferInfo> &cache = _bufferInfoCache[networkId];
+    const QPair<int, QString> key(type, bufferName.toLower());
+    QHash<QPair<int, QString>, BufferInfo>::const_iterator iter = cache.constFind(key);
+    if (iter != cache.constEnd())
+        return iter.value();
+
+    BufferInfo bufferInfo = Core::bufferInfo(user(), networkId, type, bufferName, create);
+    if (bufferInfo.isValid())
+        cache.insert(key, bufferInfo);
+    return bufferInfo;
+}
+
+
+void CoreSession::invalidateBufferInfo(BufferId bufferId)
+{
+    QHash<NetworkId, QHash<QPair<int, QString>, BufferInfo> >::iterator netIter = _bufferInfoCache.begin();
+    while (netIter != _bufferInfoCache.end()) {
+        QHash<QPair<int, QString>, BufferInfo>::iterator iter = netIter->begin();
+        while (iter != netIter->end()) {
+            if (iter->bufferId() == bufferId)
+                iter = netIter->erase(iter);
+            else
+                ++iter;
+        }
+        ++netIter;
+    }
+}
+
+
 Protocol::SessionState CoreSession::sessionState() const
 {
     QVariantList bufferInfos;
@@ -551,6 +610,7 @@ void CoreSession::destroyNetwork(NetworkId id)
                 ++messageIter;
             }
         }
+        _bufferInfoCache.remove(id);
         // remove buffers from syncer
         foreach(BufferId bufferId, removedBuffers) {
             _bufferSyncer->removeBuffer(bufferId);
@@ -563,7 +623,7 @@ void CoreSession::destroyNetwork(NetworkId id)
 
 void CoreSession::renameBuffer(const NetworkId &networkId, const QString &newName, const QString &oldName)
 {
-    BufferInfo bufferInfo = Core::bufferInfo(user(), networkId, BufferInfo::QueryBuffer, oldName, false);
+    BufferInfo bufferInfo = this->bufferInfo(networkId, BufferInfo::QueryBuffer, oldName, false);
     if (bufferInfo.isValid()) {
         _bufferSyncer->renameBuffer(bufferInfo.bufferId(), newName);
     }
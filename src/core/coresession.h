@@ -33,6 +33,7 @@
 #include "storage.h"
 
 class CoreBacklogManager;
+class CoreBacklogRetention;
 class CoreBufferSyncer;
 class CoreBufferViewManager;
 class CoreIdentity;
@@ -87,12 +88,24 @@ public:
 
     inline CoreIgnoreListManager *ignoreListManager() { return &_ignoreListManager; }
     inline CoreTransferManager *transferManager() const { return _transferManager; }
+    inline CoreBacklogRetention *backlogRetention() const { return _backlogRetention; }
 
 //   void attachNetworkConnection(NetworkConnection *conn);
 
     //! Return necessary data for restoring the session after restarting the core
     void restoreSessionState();
 
+    //! Get the BufferInfo for a buffer, consulting the session's cache first
+    /** Only valid BufferInfos are cached, so a lookup with create == false that did not find
+     *  a buffer will hit the storage again next time.
+     */
+    BufferInfo bufferInfo(NetworkId networkId, BufferInfo::Type type, const QString &bufferName, bool create = true);
+
+    //! Drop all cached lookups resolving to the given buffer
+    /** Needs to be called whenever a buffer is renamed, merged or removed.
+     */
+    void invalidateBufferInfo(BufferId bufferId);
+
 public slots:
     void addClient(RemotePeer *peer);
     void addClient(InternalPeer *peer);
@@ -140,6 +153,8 @@ signals:
 
     //void msgFromGui(uint netid, QString buf, QString message);
     void displayMsg(Message message);
+    //! Sent instead of a series of displayMsg() to clients supporting Quassel::DisplayMessages
+    void displayMessages(const QVariantList &messages);
     void displayStatusMsg(QString, QString);
 
     void scriptResult(QString result);
@@ -202,6 +217,7 @@ private:
 
     CoreBufferSyncer *_bufferSyncer;
     CoreBacklogManager *_backlogManager;
+    CoreBacklogRetention *_backlogRetention;
     CoreBufferViewManager *_bufferViewManager;
     CoreIrcListHelper *_ircListHelper;
     CoreNetworkConfig *_networkConfig;
@@ -216,6 +232,9 @@ private:
 
     QScriptEngine *scriptEngine;
 
+    // keyed by (buffer type, case-folded buffer name) per network
+    QHash<NetworkId, QHash<QPair<int, QString>, BufferInfo> > _bufferInfoCache;
+
     QList<RawMessage> _messageQueue;
     bool _processMessages;
     CoreIgnoreListManager _ignoreListManager;
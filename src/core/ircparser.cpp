@@ -39,7 +39,7 @@ IrcParser::IrcParser(CoreSession *session) :
 }
 
 
-bool IrcParser::checkParamCount(const QString &cmd, const QList<QByteArray> &params, int minParams)
+bool IrcParser::checkParamCount(const QByteArray &cmd, const QList<QByteArray> &params, int minParams)
 {
     if (params.count() < minParams) {
         qWarning() << "Expected" << minParams << "params for IRC command" << cmd << ", got:" << params;
@@ -72,6 +72,157 @@ QByteArray IrcParser::decrypt(Network *network, const QString &bufferName, const
 }
 
 
+//! The parts of a raw IRC line
+/** The prefix, command and params are created with QByteArray::fromRawData() and point into the
+ *  tokenized line, so they are only valid as long as the line is. Copy them before they escape!
+ */
+struct IrcLine
+{
+    QHash<QString, QString> tags;
+    QByteArray prefix;
+    QByteArray command;
+    QList<QByteArray> params;
+};
+
+
+// see http://ircv3.net/specs/core/message-tags-3.2.html#escaping-values
+static QString unescapeTagValue(const char *value, int length)
+{
+    QByteArray unescaped;
+    unescaped.reserve(length);
+    for (int i = 0; i < length; i++) {
+        if (value[i] != '\\') {
+            unescaped += value[i];
+            continue;
+        }
+        if (++i == length)
+            break; // a lone backslash at the end is dropped
+        switch (value[i]) {
+        case ':':
+            unescaped += ';';
+            break;
+        case 's':
+            unescaped += ' ';
+            break;
+        case 'r':
+            unescaped += '\r';
+            break;
+        case 'n':
+            unescaped += '\n';
+            break;
+        default:
+            unescaped += value[i];
+        }
+    }
+    return QString::fromUtf8(unescaped);
+}
+
+
+static void parseTags(const char *data, int length, QHash<QString, QString> &tags)
+{
+    int start = 0;
+    while (start < length) {
+        int end = start;
+        while (end < length && data[end] != ';')
+            end++;
+        int equals = start;
+        while (equals < end && data[equals] != '=')
+            equals++;
+        if (equals > start) {
+            QString key = QString::fromLatin1(data + start, equals - start);
+            tags[key] = equals < end ? unescapeTagValue(data + equals + 1, end - equals - 1) : QString();
+        }
+        start = end + 1;
+    }
+}
+
+
+//! Split a raw IRC line in a single pass, without copying any of its parts
+/** Format: [@tags ][:prefix ]command[ params...][ :trailing]
+ *  Multiple spaces between the parts (sent by some ircds) are skipped, and just like the old
+ *  parser did, an empty trailing parameter is dropped.
+ *  \return false, if the line doesn't contain a command
+ */
+static bool tokenizeIrcLine(const QByteArray &raw, IrcLine &line)
+{
+    const char *data = raw.constData();
+    const int length = raw.length();
+    int pos = 0;
+
+    if (data[0] == '@') {
+        int end = raw.indexOf(' ');
+        if (end < 0)
+            return false;
+        parseTags(data + 1, end - 1, line.tags);
+        pos = end;
+    }
+    while (pos < length && data[pos] == ' ')
+        pos++;
+
+    if (pos < length && data[pos] == ':') {
+        int end = raw.indexOf(' ', pos);
+        if (end < 0)
+            end = length;
+        line.prefix = QByteArray::fromRawData(data + pos + 1, end - pos - 1);
+        pos = end;
+    }
+
+    while (pos < length) {
+        if (data[pos] == ' ') {
+            pos++;
+            continue;
+        }
+        if (data[pos] == ':' && !line.command.isNull()) {
+            if (pos + 1 < length)
+                line.params << QByteArray::fromRawData(data + pos + 1, length - pos - 1);
+            break;
+        }
+        int end = raw.indexOf(' ', pos);
+        if (end < 0)
+            end = length;
+        QByteArray token = QByteArray::fromRawData(data + pos, end - pos);
+        if (line.command.isNull())
+            line.command = token;
+        else
+            line.params << token;
+        pos = end;
+    }
+
+    return !line.command.isEmpty();
+}
+
+
+//! @return the number of a numeric reply, 0 for any other command
+static uint numericReply(const QByteArray &command)
+{
+    if (command.length() > 9) // longer than any numeric could be, and wouldn't fit anyway
+        return 0;
+
+    uint num = 0;
+    for (int i = 0; i < command.length(); i++) {
+        char c = command.at(i);
+        if (c < '0' || c > '9')
+            return 0;
+        num = num * 10 + (c - '0');
+    }
+    return num;
+}
+
+
+//! Parse the value of an IRCv3 server-time tag, e.g. 2011-10-19T16:40:51.620Z
+static QDateTime parseServerTime(const QString &value)
+{
+    QString time = value;
+    if (time.endsWith('Z'))
+        time.chop(1);
+    QDateTime timestamp = QDateTime::fromString(time, "yyyy-MM-ddThh:mm:ss.zzz");
+    if (!timestamp.isValid())
+        timestamp = QDateTime::fromString(time, "yyyy-MM-ddThh:mm:ss");
+    timestamp.setTimeSpec(Qt::UTC);
+    return timestamp;
+}
+
+
 /* parse the raw server string and generate an appropriate event */
 /* used to be handleServerMsg()                                  */
 void IrcParser::processNetworkIncoming(NetworkDataEvent *e)
@@ -92,58 +243,28 @@ void IrcParser::processNetworkIncoming(NetworkDataEvent *e)
     }
 
     // Now we split the raw message into its various parts...
-    QString prefix;
-    QByteArray trailing;
-    QString cmd, target;
-
-    // First, check for a trailing parameter introduced by " :", since this might screw up splitting the msg
-    // NOTE: This assumes that this is true in raw encoding, but well, hopefully there are no servers running in japanese on protocol level...
-    int idx = msg.indexOf(" :");
-    if (idx >= 0) {
-        if (msg.length() > idx + 2)
-            trailing = msg.mid(idx + 2);
-        msg = msg.left(idx);
-    }
-    // OK, now it is safe to split...
-    QList<QByteArray> params = msg.split(' ');
-
-    // This could still contain empty elements due to (faulty?) ircds sending multiple spaces in a row
-    // Also, QByteArray is not nearly as convenient to work with as QString for such things :)
-    QList<QByteArray>::iterator iter = params.begin();
-    while (iter != params.end()) {
-        if (iter->isEmpty())
-            iter = params.erase(iter);
-        else
-            ++iter;
-    }
-
-    if (!trailing.isEmpty())
-        params << trailing;
-    if (params.count() < 1) {
+    IrcLine line;
+    if (!tokenizeIrcLine(msg, line)) {
         qWarning() << "Received invalid string from server!";
         return;
     }
 
-    QString foo = net->serverDecode(params.takeFirst());
+    QString prefix = net->serverDecode(line.prefix);
+    QString target;
+    QList<QByteArray> &params = line.params;
+    const QByteArray &cmd = line.command;
 
-    // a colon as the first chars indicates the existence of a prefix
-    if (foo[0] == ':') {
-        foo.remove(0, 1);
-        prefix = foo;
-        if (params.count() < 1) {
-            qWarning() << "Received invalid string from server!";
-            return;
-        }
-        foo = net->serverDecode(params.takeFirst());
+    QDateTime timestamp = e->timestamp();
+    if (line.tags.contains("time")) {
+        QDateTime serverTime = parseServerTime(line.tags.value("time"));
+        if (serverTime.isValid())
+            timestamp = serverTime;
     }
 
-    // next string without a whitespace is the command
-    cmd = foo.trimmed();
-
     QList<Event *> events;
     EventManager::EventType type = EventManager::Invalid;
 
-    uint num = cmd.toUInt();
+    uint num = numericReply(cmd);
     if (num > 0) {
         // numeric reply
         if (params.count() == 0) {
@@ -156,13 +277,9 @@ void IrcParser::processNetworkIncoming(NetworkDataEvent *e)
     }
     else {
         // any other irc command
-        QString typeName = QLatin1String("IrcEvent") + cmd.at(0).toUpper() + cmd.mid(1).toLower();
-        type = eventManager()->eventTypeByName(typeName);
-        if (type == EventManager::Invalid) {
-            type = eventManager()->eventTypeByName("IrcEventUnknown");
-            Q_ASSERT(type != EventManager::Invalid);
-        }
-        target = QString();
+        type = EventManager::ircEventTypeByCommand(cmd);
+        if (type == EventManager::Invalid)
+            type = EventManager::IrcEventUnknown;
     }
 
     // Almost always, all params are server-encoded. There's a few exceptions, let's catch them here!
@@ -180,7 +297,8 @@ void IrcParser::processNetworkIncoming(NetworkDataEvent *e)
 
         if (checkParamCount(cmd, params, 1)) {
             QString senderNick = nickFromMask(prefix);
-            QByteArray msg = params.count() < 2 ? QByteArray() : params.at(1);
+            // the message is stored in the event, so detach it from the raw line
+            QByteArray msg = params.count() < 2 ? QByteArray() : QByteArray(params.at(1).constData(), params.at(1).size());
 
             QStringList targets = net->serverDecode(params.at(0)).split(',', QString::SkipEmptyParts);
             QStringList::const_iterator targetIter;
@@ -189,7 +307,7 @@ void IrcParser::processNetworkIncoming(NetworkDataEvent *e)
 
                 msg = decrypt(net, target, msg);
 
-                events << new IrcEventRawMessage(EventManager::IrcEventRawPrivmsg, net, msg, prefix, target, e->timestamp());
+                events << new IrcEventRawMessage(EventManager::IrcEventRawPrivmsg, net, msg, prefix, target, timestamp);
             }
         }
         break;
@@ -214,7 +332,7 @@ void IrcParser::processNetworkIncoming(NetworkDataEvent *e)
                         CoreIrcChannel *chan = static_cast<CoreIrcChannel *>(net->ircChannel(channelname)); // we only have CoreIrcChannels in the core, so this cast is safe
                         if (chan && !chan->receivedWelcomeMsg()) {
                             chan->setReceivedWelcomeMsg();
-                            events << new MessageEvent(Message::Notice, net, decMsg, prefix, channelname, Message::None, e->timestamp());
+                            events << new MessageEvent(Message::Notice, net, decMsg, prefix, channelname, Message::None, timestamp);
                             continue;
                         }
                     }
@@ -238,7 +356,7 @@ void IrcParser::processNetworkIncoming(NetworkDataEvent *e)
                     events << new KeyEvent(EventManager::KeyEvent, net, prefix, target, KeyEvent::Finish, params[1].mid(14));
                 } else
 #endif
-                    events << new IrcEventRawMessage(EventManager::IrcEventRawNotice, net, params[1], prefix, target, e->timestamp());
+                    events << new IrcEventRawMessage(EventManager::IrcEventRawNotice, net, QByteArray(params[1].constData(), params[1].size()), prefix, target, timestamp);
             }
         }
         break;
@@ -319,7 +437,7 @@ void IrcParser::processNetworkIncoming(NetworkDataEvent *e)
         else
             event = new IrcEvent(type, net, prefix);
         event->setParams(decParams);
-        event->setTimestamp(e->timestamp());
+        event->setTimestamp(timestamp);
         events << event;
     }
 
@@ -44,7 +44,7 @@ signals:
 protected:
     Q_INVOKABLE void processNetworkIncoming(NetworkDataEvent *e);
 
-    bool checkParamCount(const QString &cmd, const QList<QByteArray> &params, int minParams);
+    bool checkParamCount(const QByteArray &cmd, const QList<QByteArray> &params, int minParams);
 
     // no-op if we don't have crypto support!
     QByteArray decrypt(Network *network, const QString &target, const QByteArray &message, bool isTopic = false);
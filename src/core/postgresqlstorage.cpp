@@ -20,6 +20,8 @@
 
 #include "postgresqlstorage.h"
 
+#include <limits>
+
 #include <QtSql>
 
 #include "logger.h"
@@ -321,6 +323,7 @@ void PostgreSqlStorage::delUser(UserId user)
     }
     else {
         db.commit();
+        clearSenderCache();
         emit userRemoved(user);
     }
 }
@@ -793,6 +796,7 @@ bool PostgreSqlStorage::removeNetwork(UserId user, const NetworkId &networkId)
     }
 
     db.commit();
+    clearSenderCache();
     return true;
 }
 
@@ -1361,6 +1365,7 @@ QHash<BufferId, MsgId> PostgreSqlStorage::bufferMarkerLineMsgIds(UserId user)
 
 bool PostgreSqlStorage::logMessage(Message &msg)
 {
+    QReadLocker locker(&_senderLock);
     QSqlDatabase db = logDb();
     if (!beginTransaction(db)) {
         qWarning() << "PostgreSqlStorage::logMessage(): cannot start transaction!";
@@ -1368,28 +1373,31 @@ bool PostgreSqlStorage::logMessage(Message &msg)
         return false;
     }
 
-    QSqlQuery getSenderIdQuery = executePreparedQuery("select_senderid", msg.sender(), db);
-    int senderId;
-    if (getSenderIdQuery.first()) {
-        senderId = getSenderIdQuery.value(0).toInt();
-    }
-    else {
-        // it's possible that the sender was already added by another thread
-        // since the insert might fail we're setting a savepoint
-        savePoint("sender_sp1", db);
-        QSqlQuery addSenderQuery = executePreparedQuery("insert_sender", msg.sender(), db);
-
-        if (addSenderQuery.lastError().isValid()) {
-            rollbackSavePoint("sender_sp1", db);
-            getSenderIdQuery = executePreparedQuery("select_senderid", msg.sender(), db);
-            watchQuery(getSenderIdQuery);
-            getSenderIdQuery.first();
+    int senderId = cachedSenderId(msg.sender());
+    bool newSender = (senderId == -1);
+    if (newSender) {
+        QSqlQuery getSenderIdQuery = executePreparedQuery("select_senderid", msg.sender(), db);
+        if (getSenderIdQuery.first()) {
             senderId = getSenderIdQuery.value(0).toInt();
         }
         else {
-            releaseSavePoint("sender_sp1", db);
-            addSenderQuery.first();
-            senderId = addSenderQuery.value(0).toInt();
+            // it's possible that the sender was already added by another thread
+            // since the insert might fail we're setting a savepoint
+            savePoint("sender_sp1", db);
+            QSqlQuery addSenderQuery = executePreparedQuery("insert_sender", msg.sender(), db);
+
+            if (addSenderQuery.lastError().isValid()) {
+                rollbackSavePoint("sender_sp1", db);
+                getSenderIdQuery = executePreparedQuery("select_senderid", msg.sender(), db);
+                watchQuery(getSenderIdQuery);
+                getSenderIdQuery.first();
+                senderId = getSenderIdQuery.value(0).toInt();
+            }
+            else {
+                releaseSavePoint("sender_sp1", db);
+                addSenderQuery.first();
+                senderId = addSenderQuery.value(0).toInt();
+            }
         }
     }
 
@@ -1410,6 +1418,11 @@ bool PostgreSqlStorage::logMessage(Message &msg)
     logMessageQuery.first();
     MsgId msgId = logMessageQuery.value(0).toInt();
     db.commit();
+    if (newSender) {
+        QHash<QString, int> senderIds;
+        senderIds[msg.sender()] = senderId;
+        cacheSenderIds(senderIds);
+    }
     if (msgId.isValid()) {
         msg.setMsgId(msgId);
         return true;
@@ -1422,6 +1435,7 @@ bool PostgreSqlStorage::logMessage(Message &msg)
 
 bool PostgreSqlStorage::logMessages(MessageList &msgs)
 {
+    QReadLocker locker(&_senderLock);
     QSqlDatabase db = logDb();
     if (!beginTransaction(db)) {
         qWarning() << "PostgreSqlStorage::logMessage(): cannot start transaction!";
@@ -1431,6 +1445,7 @@ bool PostgreSqlStorage::logMessages(MessageList &msgs)
 
     QList<int> senderIdList;
     QHash<QString, int> senderIds;
+    QHash<QString, int> newSenderIds;
     QSqlQuery addSenderQuery;
     QSqlQuery selectSenderQuery;;
     for (int i = 0; i < msgs.count(); i++) {
@@ -1440,6 +1455,13 @@ bool PostgreSqlStorage::logMessages(MessageList &msgs)
             continue;
         }
 
+        int cachedId = cachedSenderId(sender);
+        if (cachedId != -1) {
+            senderIdList << cachedId;
+            senderIds[sender] = cachedId;
+            continue;
+        }
+
         selectSenderQuery = executePreparedQuery("select_senderid", sender, db);
         if (selectSenderQuery.first()) {
             senderIdList << selectSenderQuery.value(0).toInt();
@@ -1464,6 +1486,7 @@ bool PostgreSqlStorage::logMessages(MessageList &msgs)
                 senderIds[sender] = addSenderQuery.value(0).toInt();
             }
         }
+        newSenderIds[sender] = senderIds[sender];
     }
 
     // yes we loop twice over the same list. This avoids alternating queries.
@@ -1498,6 +1521,7 @@ bool PostgreSqlStorage::logMessages(MessageList &msgs)
     }
 
     db.commit();
+    cacheSenderIds(newSenderIds);
     return true;
 }
 
@@ -1618,6 +1642,245 @@ QList<Message> PostgreSqlStorage::requestAllMsgs(UserId user, MsgId first, MsgId
 }
 
 
+QList<Message> PostgreSqlStorage::requestMsgsFollowing(UserId user, BufferId bufferId, MsgId msgId, int limit)
+{
+    QList<Message> messagelist;
+
+    QSqlDatabase db = logDb();
+    if (!beginReadOnlyTransaction(db)) {
+        qWarning() << "PostgreSqlStorage::requestMsgsFollowing(): cannot start read only transaction!";
+        qWarning() << " -" << qPrintable(db.lastError().text());
+        return messagelist;
+    }
+
+    BufferInfo bufferInfo = getBufferInfo(user, bufferId);
+    if (!bufferInfo.isValid()) {
+        db.rollback();
+        return messagelist;
+    }
+
+    QSqlQuery query(db);
+    query.prepare(queryString("select_messagesFollowing"));
+    query.bindValue(":bufferid", bufferId.toInt());
+    query.bindValue(":msgid", msgId.toInt());
+    query.bindValue(":limit", limit);
+    safeExec(query);
+    if (!watchQuery(query)) {
+        db.rollback();
+        return messagelist;
+    }
+
+    QDateTime timestamp;
+    while (query.next()) {
+        timestamp = query.value(1).toDateTime();
+        timestamp.setTimeSpec(Qt::UTC);
+        Message msg(timestamp,
+            bufferInfo,
+            (Message::Type)query.value(2).toUInt(),
+            query.value(5).toString(),
+            query.value(4).toString(),
+            (Message::Flags)query.value(3).toUInt());
+        msg.setMsgId(query.value(0).toInt());
+        messagelist << msg;
+    }
+
+    db.commit();
+    return messagelist;
+}
+
+
+QList<Message> PostgreSqlStorage::searchMsgs(UserId user, const QString &query, BufferId bufferId, MsgId before, int limit)
+{
+    QList<Message> messagelist;
+    if (query.trimmed().isEmpty())
+        return messagelist;
+
+    // requestBuffers uses it's own transaction.
+    QHash<BufferId, BufferInfo> bufferInfoHash;
+    foreach(BufferInfo bufferInfo, requestBuffers(user)) {
+        bufferInfoHash[bufferInfo.bufferId()] = bufferInfo;
+    }
+
+    QSqlDatabase db = logDb();
+    if (!beginReadOnlyTransaction(db)) {
+        qWarning() << "PostgreSqlStorage::searchMsgs(): cannot start read only transaction!";
+        qWarning() << " -" << qPrintable(db.lastError().text());
+        return messagelist;
+    }
+
+    // plainto_tsquery() takes care of splitting the words and ignores any operators
+    QSqlQuery searchQuery(db);
+    searchQuery.prepare(queryString("select_messagesSearch"));
+    searchQuery.bindValue(":query", query);
+    searchQuery.bindValue(":userid", user.toInt());
+    searchQuery.bindValue(":allbuffers", !bufferId.isValid());
+    searchQuery.bindValue(":bufferid", bufferId.toInt());
+    searchQuery.bindValue(":beforemsg", before == -1 ? std::numeric_limits<int>::max() : before.toInt());
+    if (limit != -1)
+        searchQuery.bindValue(":limit", limit);
+    else
+        searchQuery.bindValue(":limit", QVariant(QVariant::Int));
+    safeExec(searchQuery);
+    if (!watchQuery(searchQuery)) {
+        db.rollback();
+        return messagelist;
+    }
+
+    QDateTime timestamp;
+    while (searchQuery.next()) {
+        timestamp = searchQuery.value(2).toDateTime();
+        timestamp.setTimeSpec(Qt::UTC);
+        Message msg(timestamp,
+            bufferInfoHash[searchQuery.value(1).toInt()],
+            (Message::Type)searchQuery.value(3).toUInt(),
+            searchQuery.value(6).toString(),
+            searchQuery.value(5).toString(),
+            (Message::Flags)searchQuery.value(4).toUInt());
+        msg.setMsgId(searchQuery.value(0).toInt());
+        messagelist << msg;
+    }
+
+    db.commit();
+    return messagelist;
+}
+
+
+MsgId PostgreSqlStorage::retentionCutoff(UserId user, BufferId bufferId, int types, int count)
+{
+    Q_UNUSED(user)
+
+    MsgId cutoff;
+    if (count <= 0)
+        return cutoff;
+
+    QSqlDatabase db = logDb();
+    if (!beginReadOnlyTransaction(db)) {
+        qWarning() << "PostgreSqlStorage::retentionCutoff(): cannot start read only transaction!";
+        qWarning() << " -" << qPrintable(db.lastError().text());
+        return cutoff;
+    }
+
+    QSqlQuery query(db);
+    query.prepare(queryString("select_retention_cutoff"));
+    query.bindValue(":bufferid", bufferId.toInt());
+    query.bindValue(":types", types);
+    query.bindValue(":offset", count - 1);
+    safeExec(query);
+    if (watchQuery(query) && query.first())
+        cutoff = query.value(0).toInt();
+
+    db.commit();
+    return cutoff;
+}
+
+
+int PostgreSqlStorage::deleteMsgs(UserId user, BufferId bufferId, int types, MsgId before, const QDateTime &olderThan, int limit, qint64 &deletedBytes)
+{
+    deletedBytes = 0;
+
+    QSqlDatabase db = logDb();
+    if (!beginTransaction(db)) {
+        qWarning() << "PostgreSqlStorage::deleteMsgs(): cannot start transaction!";
+        qWarning() << " -" << qPrintable(db.lastError().text());
+        return -1;
+    }
+
+    int beforeMsg = before.isValid() ? before.toInt() : std::numeric_limits<int>::max();
+    QDateTime beforeTime = olderThan.isValid() ? olderThan.toUTC() : QDateTime(QDate(9999, 12, 31), QTime(23, 59, 59), Qt::UTC);
+
+    QSqlQuery batchQuery(db);
+    batchQuery.prepare(queryString("select_retention_batch"));
+    batchQuery.bindValue(":bufferid", bufferId.toInt());
+    batchQuery.bindValue(":userid", user.toInt());
+    batchQuery.bindValue(":types", types);
+    batchQuery.bindValue(":beforemsg", beforeMsg);
+    batchQuery.bindValue(":before", beforeTime);
+    batchQuery.bindValue(":limit", limit);
+    safeExec(batchQuery);
+    if (!watchQuery(batchQuery) || !batchQuery.first()) {
+        db.rollback();
+        return -1;
+    }
+
+    int lastMsg = batchQuery.value(0).toInt();
+    int deleted = batchQuery.value(1).toInt();
+    qint64 bytes = batchQuery.value(2).toLongLong();
+    if (deleted == 0) {
+        db.commit();
+        return 0;
+    }
+
+    // the batch is the oldest matching messages, so everything up to its newest one goes
+    QSqlQuery deleteQuery(db);
+    deleteQuery.prepare(queryString("delete_retention_batch"));
+    deleteQuery.bindValue(":bufferid", bufferId.toInt());
+    deleteQuery.bindValue(":types", types);
+    deleteQuery.bindValue(":beforemsg", beforeMsg);
+    deleteQuery.bindValue(":before", beforeTime);
+    deleteQuery.bindValue(":lastmsg", lastMsg);
+    safeExec(deleteQuery);
+    if (!watchQuery(deleteQuery)) {
+        db.rollback();
+        return -1;
+    }
+
+    deleted = deleteQuery.numRowsAffected();
+    db.commit();
+    deletedBytes = bytes;
+    return deleted;
+}
+
+
+bool PostgreSqlStorage::deleteOrphanedSenders(int &lastSenderId, int limit, int &deletedCount)
+{
+    deletedCount = 0;
+
+    QWriteLocker locker(&_senderLock);
+    QSqlDatabase db = logDb();
+    if (!beginTransaction(db)) {
+        qWarning() << "PostgreSqlStorage::deleteOrphanedSenders(): cannot start transaction!";
+        qWarning() << " -" << qPrintable(db.lastError().text());
+        return false;
+    }
+
+    QSqlQuery batchQuery(db);
+    batchQuery.prepare(queryString("select_sender_batch"));
+    batchQuery.bindValue(":lastsender", lastSenderId);
+    batchQuery.bindValue(":limit", limit);
+    safeExec(batchQuery);
+    if (!watchQuery(batchQuery) || !batchQuery.first()) {
+        db.rollback();
+        return false;
+    }
+
+    int maxSenderId = batchQuery.value(0).toInt();
+    int checked = batchQuery.value(1).toInt();
+    if (checked == 0) {
+        db.commit();
+        return false;
+    }
+
+    QSqlQuery deleteQuery(db);
+    deleteQuery.prepare(queryString("delete_orphaned_senders"));
+    deleteQuery.bindValue(":lastsender", lastSenderId);
+    deleteQuery.bindValue(":maxsender", maxSenderId);
+    safeExec(deleteQuery);
+    if (!watchQuery(deleteQuery)) {
+        db.rollback();
+        return false;
+    }
+
+    deletedCount = deleteQuery.numRowsAffected();
+    db.commit();
+    // still holding the lock, so no insert can pick up a deleted senderid from the cache
+    if (deletedCount > 0)
+        clearSenderCache();
+
+    lastSenderId = maxSenderId;
+    return checked == limit;
+}
+
+
 // void PostgreSqlStorage::safeExec(QSqlQuery &query) {
 //   qDebug() << "PostgreSqlStorage::safeExec";
 //   qDebug() << "   executing:\n" << query.executedQuery();
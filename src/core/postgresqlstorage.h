@@ -23,6 +23,7 @@
 
 #include "abstractsqlstorage.h"
 
+#include <QReadWriteLock>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 
@@ -101,6 +102,13 @@ public slots:
     virtual bool logMessages(MessageList &msgs);
     virtual QList<Message> requestMsgs(UserId user, BufferId bufferId, MsgId first = -1, MsgId last = -1, int limit = -1);
     virtual QList<Message> requestAllMsgs(UserId user, MsgId first = -1, MsgId last = -1, int limit = -1);
+    virtual QList<Message> requestMsgsFollowing(UserId user, BufferId bufferId, MsgId msgId, int limit);
+    virtual QList<Message> searchMsgs(UserId user, const QString &query, BufferId bufferId = BufferId(), MsgId before = -1, int limit = -1);
+
+    /* Backlog retention */
+    virtual MsgId retentionCutoff(UserId user, BufferId bufferId, int types, int count);
+    virtual int deleteMsgs(UserId user, BufferId bufferId, int types, MsgId before, const QDateTime &olderThan, int limit, qint64 &deletedBytes);
+    virtual bool deleteOrphanedSenders(int &lastSenderId, int limit, int &deletedCount);
 
 protected:
     virtual bool initDbSession(QSqlDatabase &db);
@@ -138,6 +146,10 @@ private:
     QString _databaseName;
     QString _userName;
     QString _password;
+
+    // Logging messages holds this for reading while resolving senders and inserting, deleting orphaned senders
+    // holds it for writing, so no insert can use the cached id of a sender that is being deleted
+    QReadWriteLock _senderLock;
 };
 
 
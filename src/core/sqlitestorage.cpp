@@ -20,6 +20,8 @@
 
 #include "sqlitestorage.h"
 
+#include <limits>
+
 #include <QtSql>
 
 #include "logger.h"
@@ -28,9 +30,30 @@
 
 int SqliteStorage::_maxRetryCount = 150;
 
+struct SqliteStorage::GroupCommitRequest {
+    MessageList *msgs;
+    bool done;
+    bool success;
+    GroupCommitRequest(MessageList *msgs_) : msgs(msgs_), done(false), success(false) {}
+};
+
 SqliteStorage::SqliteStorage(QObject *parent)
-    : AbstractSqlStorage(parent)
+    : AbstractSqlStorage(parent),
+    _commitQueueSize(0),
+    _commitInProgress(false),
+    _searchIndex(false)
 {
+    _commitWindow = qMax(0, Quassel::optionValue("sqlite-commit-window").toInt());
+    _commitBatchSize = qMax(1, Quassel::optionValue("sqlite-commit-batch").toInt());
+
+    _walMode = Quassel::isOptionSet("sqlite-wal");
+    _synchronous = Quassel::optionValue("sqlite-synchronous").toUpper();
+    QStringList synchronousModes = QStringList() << "OFF" << "NORMAL" << "FULL";
+    if (!synchronousModes.contains(_synchronous)) {
+        qWarning() << "Invalid value for --sqlite-synchronous, using FULL:" << _synchronous;
+        _synchronous = "FULL";
+    }
+    _walAutoCheckpoint = Quassel::optionValue("sqlite-wal-autocheckpoint").toInt();
 }
 
 
@@ -39,6 +62,15 @@ SqliteStorage::~SqliteStorage()
 }
 
 
+Storage::State SqliteStorage::init(const QVariantMap &settings)
+{
+    State state = AbstractSqlStorage::init(settings);
+    if (state == IsReady)
+        setupSearchIndex();
+    return state;
+}
+
+
 bool SqliteStorage::isAvailable() const
 {
     if (!QSqlDatabase::isDriverAvailable("QSQLITE")) return false;
@@ -63,6 +95,35 @@ QString SqliteStorage::description() const
 }
 
 
+bool SqliteStorage::initDbSession(QSqlDatabase &db)
+{
+    // read-only connections can't (and don't need to) change the journal settings
+    if (db.connectOptions().contains("QSQLITE_OPEN_READONLY"))
+        return true;
+
+    if (_walMode) {
+        // the journal mode is persistent, but setting it again is cheap
+        QSqlQuery query = db.exec("PRAGMA journal_mode = WAL");
+        if (!query.first() || query.value(0).toString().toLower() != "wal") {
+            qCritical() << "SqliteStorage::initDbSession(): unable to enable WAL journal mode!";
+            return false;
+        }
+        query = db.exec(QString("PRAGMA wal_autocheckpoint = %1").arg(_walAutoCheckpoint));
+        if (query.lastError().isValid()) {
+            qCritical() << "SqliteStorage::initDbSession(): unable to set WAL checkpoint interval:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    QSqlQuery query = db.exec(QString("PRAGMA synchronous = %1").arg(_synchronous));
+    if (query.lastError().isValid()) {
+        qCritical() << "SqliteStorage::initDbSession(): unable to set synchronous mode:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+
 int SqliteStorage::installedSchemaVersion()
 {
     // only used when there is a singlethread (during startup)
@@ -116,6 +177,34 @@ bool SqliteStorage::setupSchemaVersion(int version)
 }
 
 
+void SqliteStorage::setupSearchIndex()
+{
+    // only used when there is a singlethread (during startup)
+    // so we don't need locking here
+    QSqlDatabase db = logDb();
+    QSqlQuery query = db.exec(queryString("select_backlog_fts_exists"));
+    if (query.first()) {
+        _searchIndex = true;
+        return;
+    }
+
+    quInfo() << "Building full-text search index for the backlog, this may take a while...";
+    db.transaction();
+    QStringList setupQueries = QStringList() << "create_backlog_fts" << "create_backlog_fts_delete_trigger" << "rebuild_backlog_fts";
+    foreach(QString queryName, setupQueries) {
+        query = db.exec(queryString(queryName));
+        if (query.lastError().isValid()) {
+            qWarning() << "SqliteStorage::setupSearchIndex(): unable to set up the full-text search index, backlog search will be slow:" << query.lastError().text();
+            db.rollback();
+            return;
+        }
+    }
+    db.commit();
+    _searchIndex = true;
+    quInfo() << "Full-text search index is ready.";
+}
+
+
 UserId SqliteStorage::addUser(const QString &user, const QString &password)
 {
     QSqlDatabase db = logDb();
@@ -287,6 +376,7 @@ void SqliteStorage::delUser(UserId user)
         // I hate the lack of foreign keys and on delete cascade... :(
         db.commit();
     }
+    clearSenderCache();
     unlock();
 
     emit userRemoved(user);
@@ -810,6 +900,7 @@ bool SqliteStorage::removeNetwork(UserId user, const NetworkId &networkId)
 
     db.commit();
     unlock();
+    clearSenderCache();
     return true;
 }
 
@@ -1102,8 +1193,7 @@ BufferInfo SqliteStorage::bufferInfo(UserId user, const NetworkId &networkId, Bu
 
     BufferInfo bufferInfo;
     {
-        QSqlQuery query(db);
-        query.prepare(queryString("select_bufferByName"));
+        QSqlQuery query = cachedQuery("select_bufferByName");
         query.bindValue(":networkid", networkId.toInt());
         query.bindValue(":userid", user.toInt());
         query.bindValue(":buffercname", buffer.toLower());
@@ -1122,11 +1212,12 @@ BufferInfo SqliteStorage::bufferInfo(UserId user, const NetworkId &networkId, Bu
                     qCritical() << i << ":" << list.at(i).toString().toLatin1().data();
                 Q_ASSERT(false);
             }
+            query.finish();
         }
         else if (create) {
+            query.finish();
             // let's create the buffer
-            QSqlQuery createQuery(db);
-            createQuery.prepare(queryString("insert_buffer"));
+            QSqlQuery createQuery = cachedQuery("insert_buffer");
             createQuery.bindValue(":userid", user.toInt());
             createQuery.bindValue(":networkid", networkId.toInt());
             createQuery.bindValue(":buffertype", (int)type);
@@ -1140,6 +1231,9 @@ BufferInfo SqliteStorage::bufferInfo(UserId user, const NetworkId &networkId, Bu
             watchQuery(createQuery);
             bufferInfo = BufferInfo(createQuery.lastInsertId().toInt(), networkId, type, 0, buffer);
         }
+        else {
+            query.finish();
+        }
     }
     db.commit();
     unlock();
@@ -1466,104 +1560,158 @@ QHash<BufferId, MsgId> SqliteStorage::bufferMarkerLineMsgIds(UserId user)
 
 bool SqliteStorage::logMessage(Message &msg)
 {
-    QSqlDatabase db = logDb();
-    db.transaction();
+    MessageList msgs;
+    msgs << msg;
+    if (!logMessages(msgs))
+        return false;
 
-    bool error = false;
-    {
-        QSqlQuery logMessageQuery(db);
-        logMessageQuery.prepare(queryString("insert_message"));
+    msg.setMsgId(msgs.first().msgId());
+    return true;
+}
 
-        logMessageQuery.bindValue(":time", msg.timestamp().toTime_t());
-        logMessageQuery.bindValue(":bufferid", msg.bufferInfo().bufferId().toInt());
-        logMessageQuery.bindValue(":type", msg.type());
-        logMessageQuery.bindValue(":flags", (int)msg.flags());
-        logMessageQuery.bindValue(":sender", msg.sender());
-        logMessageQuery.bindValue(":message", msg.contents());
 
-        lockForWrite();
-        safeExec(logMessageQuery);
-
-        if (logMessageQuery.lastError().isValid()) {
-            // constraint violation - must be NOT NULL constraint - probably the sender is missing...
-            if (logMessageQuery.lastError().number() == 19) {
-                QSqlQuery addSenderQuery(db);
-                addSenderQuery.prepare(queryString("insert_sender"));
-                addSenderQuery.bindValue(":sender", msg.sender());
-                safeExec(addSenderQuery);
-                safeExec(logMessageQuery);
-                error = !watchQuery(logMessageQuery);
-            }
-            else {
-                watchQuery(logMessageQuery);
-            }
+bool SqliteStorage::logMessages(MessageList &msgs)
+{
+    if (msgs.isEmpty())
+        return true;
+
+    GroupCommitRequest request(&msgs);
+
+    QMutexLocker locker(&_commitMutex);
+    _commitQueue << &request;
+    _commitQueueSize += msgs.count();
+    if (_commitQueueSize >= _commitBatchSize)
+        _commitCondition.wakeAll(); // let the leader flush early
+
+    while (!request.done) {
+        if (_commitInProgress) {
+            // another session is the leader; it will write our messages as well
+            _commitCondition.wait(&_commitMutex);
+            continue;
         }
-        if (!error) {
-            MsgId msgId = logMessageQuery.lastInsertId().toInt();
-            if (msgId.isValid()) {
-                msg.setMsgId(msgId);
-            }
-            else {
-                error = true;
+
+        // we're the leader for the next group
+        _commitInProgress = true;
+        if (_commitWindow > 0) {
+            QTime windowTimer;
+            windowTimer.start();
+            int remaining = _commitWindow;
+            while (remaining > 0 && _commitQueueSize < _commitBatchSize) {
+                _commitCondition.wait(&_commitMutex, remaining);
+                remaining = _commitWindow - windowTimer.elapsed();
             }
         }
-    }
 
-    if (error) {
-        db.rollback();
-    }
-    else {
-        db.commit();
+        QList<GroupCommitRequest *> group = _commitQueue;
+        _commitQueue.clear();
+        _commitQueueSize = 0;
+        locker.unlock();
+
+        QList<MessageList *> msgLists;
+        foreach(GroupCommitRequest *req, group)
+            msgLists << req->msgs;
+
+        bool success = commitMessages(msgLists);
+        if (success) {
+            foreach(GroupCommitRequest *req, group)
+                req->success = true;
+        }
+        else if (group.count() > 1) {
+            // don't let a single bad batch drop the messages of all other sessions
+            foreach(GroupCommitRequest *req, group)
+                req->success = commitMessages(QList<MessageList *>() << req->msgs);
+        }
+
+        locker.relock();
+        foreach(GroupCommitRequest *req, group)
+            req->done = true;
+        _commitInProgress = false;
+        _commitCondition.wakeAll();
     }
 
-    unlock();
-    return !error;
+    return request.success;
 }
 
 
-bool SqliteStorage::logMessages(MessageList &msgs)
+bool SqliteStorage::commitMessages(const QList<MessageList *> &msgLists)
 {
     QSqlDatabase db = logDb();
     db.transaction();
 
+    // resolve the senderids up front; cached senders need no query at all
+    QHash<QString, int> senderIds;
+    QHash<QString, int> newSenderIds;
     {
-        QSet<QString> senders;
-        QSqlQuery addSenderQuery(db);
-        addSenderQuery.prepare(queryString("insert_sender"));
+        QSqlQuery addSenderQuery = cachedQuery("insert_sender");
+        QSqlQuery selectSenderQuery = cachedQuery("select_senderid");
         lockForWrite();
-        for (int i = 0; i < msgs.count(); i++) {
-            const QString &sender = msgs.at(i).sender();
-            if (senders.contains(sender))
-                continue;
-            senders << sender;
-
-            addSenderQuery.bindValue(":sender", sender);
-            safeExec(addSenderQuery);
+        foreach(MessageList *msgs, msgLists) {
+            for (int i = 0; i < msgs->count(); i++) {
+                const QString &sender = msgs->at(i).sender();
+                if (senderIds.contains(sender))
+                    continue;
+
+                int senderId = cachedSenderId(sender);
+                if (senderId == -1) {
+                    addSenderQuery.bindValue(":sender", sender);
+                    if (safeExec(addSenderQuery)) {
+                        senderId = addSenderQuery.lastInsertId().toInt();
+                    }
+                    else {
+                        // the sender is already known
+                        selectSenderQuery.bindValue(":sender", sender);
+                        safeExec(selectSenderQuery);
+                        if (watchQuery(selectSenderQuery) && selectSenderQuery.first())
+                            senderId = selectSenderQuery.value(0).toInt();
+                        selectSenderQuery.finish();
+                    }
+                    if (senderId == -1)
+                        continue; // the insert will fail on the NOT NULL constraint below
+                    newSenderIds[sender] = senderId;
+                }
+                senderIds[sender] = senderId;
+            }
         }
     }
 
     bool error = false;
     {
-        QSqlQuery logMessageQuery(db);
-        logMessageQuery.prepare(queryString("insert_message"));
-        for (int i = 0; i < msgs.count(); i++) {
-            Message &msg = msgs[i];
-
-            logMessageQuery.bindValue(":time", msg.timestamp().toTime_t());
-            logMessageQuery.bindValue(":bufferid", msg.bufferInfo().bufferId().toInt());
-            logMessageQuery.bindValue(":type", msg.type());
-            logMessageQuery.bindValue(":flags", (int)msg.flags());
-            logMessageQuery.bindValue(":sender", msg.sender());
-            logMessageQuery.bindValue(":message", msg.contents());
-
-            safeExec(logMessageQuery);
-            if (!watchQuery(logMessageQuery)) {
-                error = true;
-                break;
-            }
-            else {
-                msg.setMsgId(logMessageQuery.lastInsertId().toInt());
+        QSqlQuery logMessageQuery = cachedQuery("insert_message");
+        QSqlQuery indexMessageQuery;
+        if (_searchIndex)
+            indexMessageQuery = cachedQuery("insert_message_fts");
+        foreach(MessageList *msgs, msgLists) {
+            for (int i = 0; i < msgs->count(); i++) {
+                Message &msg = (*msgs)[i];
+
+                logMessageQuery.bindValue(":time", msg.timestamp().toTime_t());
+                logMessageQuery.bindValue(":bufferid", msg.bufferInfo().bufferId().toInt());
+                logMessageQuery.bindValue(":type", msg.type());
+                logMessageQuery.bindValue(":flags", (int)msg.flags());
+                logMessageQuery.bindValue(":senderid", senderIds.contains(msg.sender()) ? senderIds[msg.sender()] : QVariant());
+                logMessageQuery.bindValue(":message", msg.contents());
+
+                safeExec(logMessageQuery);
+                if (!watchQuery(logMessageQuery)) {
+                    error = true;
+                    break;
+                }
+                else {
+                    msg.setMsgId(logMessageQuery.lastInsertId().toInt());
+                }
+
+                if (_searchIndex) {
+                    indexMessageQuery.bindValue(":messageid", msg.msgId().toInt());
+                    indexMessageQuery.bindValue(":message", msg.contents());
+                    safeExec(indexMessageQuery);
+                    if (!watchQuery(indexMessageQuery)) {
+                        error = true;
+                        break;
+                    }
+                }
             }
+            if (error)
+                break;
         }
     }
 
@@ -1571,12 +1719,16 @@ bool SqliteStorage::logMessages(MessageList &msgs)
         db.rollback();
         unlock();
         // we had a rollback in the db so we need to reset all msgIds
-        for (int i = 0; i < msgs.count(); i++) {
-            msgs[i].setMsgId(MsgId());
+        foreach(MessageList *msgs, msgLists) {
+            for (int i = 0; i < msgs->count(); i++) {
+                (*msgs)[i].setMsgId(MsgId());
+            }
         }
     }
     else {
         db.commit();
+        // cache the new senderids before unlocking, so deleteOrphanedSenders() can't remove them in between
+        cacheSenderIds(newSenderIds);
         unlock();
     }
     return !error;
@@ -1587,7 +1739,7 @@ QList<Message> SqliteStorage::requestMsgs(UserId user, BufferId bufferId, MsgId
 {
     QList<Message> messagelist;
 
-    QSqlDatabase db = logDb();
+    QSqlDatabase db = readDb();
     db.transaction();
 
     bool error = false;
@@ -1595,39 +1747,39 @@ QList<Message> SqliteStorage::requestMsgs(UserId user, BufferId bufferId, MsgId
     {
         // code dupication from getBufferInfo:
         // this is due to the impossibility of nesting transactions and recursive locking
-        QSqlQuery bufferInfoQuery(db);
-        bufferInfoQuery.prepare(queryString("select_buffer_by_id"));
+        QSqlQuery bufferInfoQuery = cachedReadQuery("select_buffer_by_id");
         bufferInfoQuery.bindValue(":userid", user.toInt());
         bufferInfoQuery.bindValue(":bufferid", bufferId.toInt());
 
-        lockForRead();
+        lockForBacklogRead();
         safeExec(bufferInfoQuery);
         error = !watchQuery(bufferInfoQuery) || !bufferInfoQuery.first();
         if (!error) {
             bufferInfo = BufferInfo(bufferInfoQuery.value(0).toInt(), bufferInfoQuery.value(1).toInt(), (BufferInfo::Type)bufferInfoQuery.value(2).toInt(), 0, bufferInfoQuery.value(4).toString());
             error = !bufferInfo.isValid();
         }
+        bufferInfoQuery.finish();
     }
     if (error) {
         db.rollback();
-        unlock();
+        unlockBacklogRead();
         return messagelist;
     }
 
     {
-        QSqlQuery query(db);
-        if (last == -1 && first == -1) {
-            query.prepare(queryString("select_messagesNewestK"));
-        }
-        else if (last == -1) {
-            query.prepare(queryString("select_messagesNewerThan"));
+        QString queryName;
+        if (last == -1 && first == -1)
+            queryName = "select_messagesNewestK";
+        else if (last == -1)
+            queryName = "select_messagesNewerThan";
+        else
+            queryName = "select_messages";
+
+        QSqlQuery query = cachedReadQuery(queryName);
+        if (last != -1 || first != -1)
             query.bindValue(":firstmsg", first.toInt());
-        }
-        else {
-            query.prepare(queryString("select_messages"));
+        if (last != -1)
             query.bindValue(":lastmsg", last.toInt());
-            query.bindValue(":firstmsg", first.toInt());
-        }
         query.bindValue(":bufferid", bufferId.toInt());
         query.bindValue(":limit", limit);
 
@@ -1644,9 +1796,10 @@ QList<Message> SqliteStorage::requestMsgs(UserId user, BufferId bufferId, MsgId
             msg.setMsgId(query.value(0).toInt());
             messagelist << msg;
         }
+        query.finish();
     }
     db.commit();
-    unlock();
+    unlockBacklogRead();
 
     return messagelist;
 }
@@ -1656,31 +1809,26 @@ QList<Message> SqliteStorage::requestAllMsgs(UserId user, MsgId first, MsgId las
 {
     QList<Message> messagelist;
 
-    QSqlDatabase db = logDb();
+    QSqlDatabase db = readDb();
     db.transaction();
 
     QHash<BufferId, BufferInfo> bufferInfoHash;
     {
-        QSqlQuery bufferInfoQuery(db);
-        bufferInfoQuery.prepare(queryString("select_buffers"));
+        QSqlQuery bufferInfoQuery = cachedReadQuery("select_buffers");
         bufferInfoQuery.bindValue(":userid", user.toInt());
 
-        lockForRead();
+        lockForBacklogRead();
         safeExec(bufferInfoQuery);
         watchQuery(bufferInfoQuery);
         while (bufferInfoQuery.next()) {
             BufferInfo bufferInfo = BufferInfo(bufferInfoQuery.value(0).toInt(), bufferInfoQuery.value(1).toInt(), (BufferInfo::Type)bufferInfoQuery.value(2).toInt(), bufferInfoQuery.value(3).toInt(), bufferInfoQuery.value(4).toString());
             bufferInfoHash[bufferInfo.bufferId()] = bufferInfo;
         }
+        bufferInfoQuery.finish();
 
-        QSqlQuery query(db);
-        if (last == -1) {
-            query.prepare(queryString("select_messagesAllNew"));
-        }
-        else {
-            query.prepare(queryString("select_messagesAll"));
+        QSqlQuery query = cachedReadQuery(last == -1 ? "select_messagesAllNew" : "select_messagesAll");
+        if (last != -1)
             query.bindValue(":lastmsg", last.toInt());
-        }
         query.bindValue(":userid", user.toInt());
         query.bindValue(":firstmsg", first.toInt());
         query.bindValue(":limit", limit);
@@ -1698,13 +1846,310 @@ QList<Message> SqliteStorage::requestAllMsgs(UserId user, MsgId first, MsgId las
             msg.setMsgId(query.value(0).toInt());
             messagelist << msg;
         }
+        query.finish();
     }
     db.commit();
-    unlock();
+    unlockBacklogRead();
+    return messagelist;
+}
+
+
+QList<Message> SqliteStorage::requestMsgsFollowing(UserId user, BufferId bufferId, MsgId msgId, int limit)
+{
+    QList<Message> messagelist;
+
+    QSqlDatabase db = readDb();
+    db.transaction();
+
+    bool error = false;
+    BufferInfo bufferInfo;
+    {
+        QSqlQuery bufferInfoQuery = cachedReadQuery("select_buffer_by_id");
+        bufferInfoQuery.bindValue(":userid", user.toInt());
+        bufferInfoQuery.bindValue(":bufferid", bufferId.toInt());
+
+        lockForBacklogRead();
+        safeExec(bufferInfoQuery);
+        error = !watchQuery(bufferInfoQuery) || !bufferInfoQuery.first();
+        if (!error) {
+            bufferInfo = BufferInfo(bufferInfoQuery.value(0).toInt(), bufferInfoQuery.value(1).toInt(), (BufferInfo::Type)bufferInfoQuery.value(2).toInt(), 0, bufferInfoQuery.value(4).toString());
+            error = !bufferInfo.isValid();
+        }
+        bufferInfoQuery.finish();
+    }
+    if (error) {
+        db.rollback();
+        unlockBacklogRead();
+        return messagelist;
+    }
+
+    {
+        QSqlQuery query = cachedReadQuery("select_messagesFollowing");
+        query.bindValue(":bufferid", bufferId.toInt());
+        query.bindValue(":msgid", msgId.toInt());
+        query.bindValue(":limit", limit);
+
+        safeExec(query);
+        watchQuery(query);
+
+        while (query.next()) {
+            Message msg(QDateTime::fromTime_t(query.value(1).toInt()),
+                bufferInfo,
+                (Message::Type)query.value(2).toUInt(),
+                query.value(5).toString(),
+                query.value(4).toString(),
+                (Message::Flags)query.value(3).toUInt());
+            msg.setMsgId(query.value(0).toInt());
+            messagelist << msg;
+        }
+        query.finish();
+    }
+    db.commit();
+    unlockBacklogRead();
+
     return messagelist;
 }
 
 
+QList<Message> SqliteStorage::searchMsgs(UserId user, const QString &query, BufferId bufferId, MsgId before, int limit)
+{
+    QList<Message> messagelist;
+
+    QStringList words = query.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    if (words.isEmpty())
+        return messagelist;
+
+    QString queryName;
+    QString pattern;
+    if (_searchIndex) {
+        // quote every word, so FTS operators in the search string are taken literally
+        queryName = "select_messagesSearch";
+        for (int i = 0; i < words.count(); i++)
+            words[i] = QString("\"%1\"").arg(words[i].replace('"', "\"\""));
+        pattern = words.join(" ");
+    }
+    else {
+        // without the index, we can only look for the search string as a whole
+        queryName = "select_messagesSearchFallback";
+        pattern = query.trimmed();
+        pattern.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+        pattern = QLatin1Char('%') + pattern + QLatin1Char('%');
+    }
+
+    QSqlDatabase db = readDb();
+    db.transaction();
+
+    QHash<BufferId, BufferInfo> bufferInfoHash;
+    {
+        QSqlQuery bufferInfoQuery = cachedReadQuery("select_buffers");
+        bufferInfoQuery.bindValue(":userid", user.toInt());
+
+        lockForBacklogRead();
+        safeExec(bufferInfoQuery);
+        watchQuery(bufferInfoQuery);
+        while (bufferInfoQuery.next()) {
+            BufferInfo bufferInfo = BufferInfo(bufferInfoQuery.value(0).toInt(), bufferInfoQuery.value(1).toInt(), (BufferInfo::Type)bufferInfoQuery.value(2).toInt(), bufferInfoQuery.value(3).toInt(), bufferInfoQuery.value(4).toString());
+            bufferInfoHash[bufferInfo.bufferId()] = bufferInfo;
+        }
+        bufferInfoQuery.finish();
+
+        QSqlQuery searchQuery = cachedReadQuery(queryName);
+        searchQuery.bindValue(_searchIndex ? ":query" : ":pattern", pattern);
+        searchQuery.bindValue(":userid", user.toInt());
+        searchQuery.bindValue(":allbuffers", !bufferId.isValid());
+        searchQuery.bindValue(":bufferid", bufferId.toInt());
+        searchQuery.bindValue(":beforemsg", before == -1 ? std::numeric_limits<int>::max() : before.toInt());
+        searchQuery.bindValue(":limit", limit);
+        safeExec(searchQuery);
+
+        watchQuery(searchQuery);
+
+        while (searchQuery.next()) {
+            Message msg(QDateTime::fromTime_t(searchQuery.value(2).toInt()),
+                bufferInfoHash[searchQuery.value(1).toInt()],
+                (Message::Type)searchQuery.value(3).toUInt(),
+                searchQuery.value(6).toString(),
+                searchQuery.value(5).toString(),
+                (Message::Flags)searchQuery.value(4).toUInt());
+            msg.setMsgId(searchQuery.value(0).toInt());
+            messagelist << msg;
+        }
+        searchQuery.finish();
+    }
+    db.commit();
+    unlockBacklogRead();
+    return messagelist;
+}
+
+
+MsgId SqliteStorage::retentionCutoff(UserId user, BufferId bufferId, int types, int count)
+{
+    Q_UNUSED(user)
+
+    MsgId cutoff;
+    if (count <= 0)
+        return cutoff;
+
+    QSqlDatabase db = readDb();
+    db.transaction();
+    {
+        QSqlQuery query = cachedReadQuery("select_retention_cutoff");
+        query.bindValue(":bufferid", bufferId.toInt());
+        query.bindValue(":types", types);
+        query.bindValue(":offset", count - 1);
+
+        lockForBacklogRead();
+        safeExec(query);
+        if (watchQuery(query) && query.first())
+            cutoff = query.value(0).toInt();
+        query.finish();
+    }
+    db.commit();
+    unlockBacklogRead();
+    return cutoff;
+}
+
+
+int SqliteStorage::deleteMsgs(UserId user, BufferId bufferId, int types, MsgId before, const QDateTime &olderThan, int limit, qint64 &deletedBytes)
+{
+    deletedBytes = 0;
+
+    QSqlDatabase db = logDb();
+    db.transaction();
+
+    int deleted = -1;
+    {
+        int beforeMsg = before.isValid() ? before.toInt() : std::numeric_limits<int>::max();
+        qint64 beforeTime = olderThan.isValid() ? (qint64)olderThan.toTime_t() : std::numeric_limits<qint64>::max();
+
+        QSqlQuery batchQuery = cachedQuery("select_retention_batch");
+        batchQuery.bindValue(":bufferid", bufferId.toInt());
+        batchQuery.bindValue(":userid", user.toInt());
+        batchQuery.bindValue(":types", types);
+        batchQuery.bindValue(":beforemsg", beforeMsg);
+        batchQuery.bindValue(":before", beforeTime);
+        batchQuery.bindValue(":limit", limit);
+
+        lockForWrite();
+        safeExec(batchQuery);
+        if (watchQuery(batchQuery) && batchQuery.first()) {
+            int lastMsg = batchQuery.value(0).toInt();
+            deleted = batchQuery.value(1).toInt();
+            deletedBytes = batchQuery.value(2).toLongLong();
+            batchQuery.finish();
+
+            if (deleted > 0) {
+                // the batch is the oldest matching messages, so everything up to its newest one goes
+                QSqlQuery deleteQuery = cachedQuery("delete_retention_batch");
+                deleteQuery.bindValue(":bufferid", bufferId.toInt());
+                deleteQuery.bindValue(":types", types);
+                deleteQuery.bindValue(":beforemsg", beforeMsg);
+                deleteQuery.bindValue(":before", beforeTime);
+                deleteQuery.bindValue(":lastmsg", lastMsg);
+                safeExec(deleteQuery);
+                if (watchQuery(deleteQuery))
+                    deleted = deleteQuery.numRowsAffected();
+                else
+                    deleted = -1;
+            }
+        }
+        else {
+            batchQuery.finish();
+        }
+    }
+
+    if (deleted < 0) {
+        db.rollback();
+        deletedBytes = 0;
+    }
+    else {
+        db.commit();
+    }
+    unlock();
+    return deleted;
+}
+
+
+bool SqliteStorage::deleteOrphanedSenders(int &lastSenderId, int limit, int &deletedCount)
+{
+    deletedCount = 0;
+
+    QSqlDatabase db = logDb();
+    db.transaction();
+
+    bool error = false;
+    bool more = false;
+    {
+        QSqlQuery batchQuery = cachedQuery("select_sender_batch");
+        batchQuery.bindValue(":lastsender", lastSenderId);
+        batchQuery.bindValue(":limit", limit);
+
+        lockForWrite();
+        safeExec(batchQuery);
+        if (watchQuery(batchQuery) && batchQuery.first()) {
+            int maxSenderId = batchQuery.value(0).toInt();
+            int checked = batchQuery.value(1).toInt();
+            batchQuery.finish();
+
+            if (checked > 0) {
+                QSqlQuery deleteQuery = cachedQuery("delete_orphaned_senders");
+                deleteQuery.bindValue(":lastsender", lastSenderId);
+                deleteQuery.bindValue(":maxsender", maxSenderId);
+                safeExec(deleteQuery);
+                if (watchQuery(deleteQuery)) {
+                    deletedCount = deleteQuery.numRowsAffected();
+                    lastSenderId = maxSenderId;
+                    more = checked == limit;
+                }
+                else {
+                    error = true;
+                }
+            }
+        }
+        else {
+            batchQuery.finish();
+            error = true;
+        }
+    }
+
+    if (error) {
+        db.rollback();
+        deletedCount = 0;
+    }
+    else {
+        db.commit();
+        // still holding the lock, so no insert can pick up a deleted senderid from the cache
+        if (deletedCount > 0)
+            clearSenderCache();
+    }
+    unlock();
+    return more;
+}
+
+
+qint64 SqliteStorage::reclaimableSpace()
+{
+    qint64 freePages = -1;
+    qint64 pageSize = -1;
+
+    QSqlDatabase db = logDb();
+    lockForRead();
+    {
+        QSqlQuery query = db.exec("PRAGMA freelist_count");
+        if (query.first())
+            freePages = query.value(0).toLongLong();
+        query = db.exec("PRAGMA page_size");
+        if (query.first())
+            pageSize = query.value(0).toLongLong();
+    }
+    unlock();
+
+    if (freePages < 0 || pageSize < 0)
+        return -1;
+    return freePages * pageSize;
+}
+
+
 QString SqliteStorage::backlogFile()
 {
     return Quassel::configDirPath() + "quassel-storage.sqlite";
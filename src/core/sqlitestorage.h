@@ -40,6 +40,7 @@ public:
 public slots:
     /* General */
 
+    virtual State init(const QVariantMap &settings = QVariantMap());
     bool isAvailable() const;
     QString displayName() const;
     virtual inline QStringList setupKeys() const { return QStringList(); }
@@ -102,11 +103,22 @@ public slots:
     virtual bool logMessages(MessageList &msgs);
     virtual QList<Message> requestMsgs(UserId user, BufferId bufferId, MsgId first = -1, MsgId last = -1, int limit = -1);
     virtual QList<Message> requestAllMsgs(UserId user, MsgId first = -1, MsgId last = -1, int limit = -1);
+    virtual QList<Message> requestMsgsFollowing(UserId user, BufferId bufferId, MsgId msgId, int limit);
+    virtual QList<Message> searchMsgs(UserId user, const QString &query, BufferId bufferId = BufferId(), MsgId before = -1, int limit = -1);
+
+    /* Backlog retention */
+    virtual MsgId retentionCutoff(UserId user, BufferId bufferId, int types, int count);
+    virtual int deleteMsgs(UserId user, BufferId bufferId, int types, MsgId before, const QDateTime &olderThan, int limit, qint64 &deletedBytes);
+    virtual bool deleteOrphanedSenders(int &lastSenderId, int limit, int &deletedCount);
+    virtual qint64 reclaimableSpace();
 
 protected:
     inline virtual void setConnectionProperties(const QVariantMap & /* properties */) {}
     inline virtual QString driverName() { return "QSQLITE"; }
     inline virtual QString databaseName() { return backlogFile(); }
+    virtual bool initDbSession(QSqlDatabase &db);
+    inline virtual bool useReadConnections() { return _walMode; }
+    inline virtual QString readConnectOptions() { return "QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000"; }
     virtual int installedSchemaVersion();
     virtual bool updateSchemaVersion(int newVersion);
     virtual bool setupSchemaVersion(int version);
@@ -117,11 +129,43 @@ private:
     void bindNetworkInfo(QSqlQuery &query, const NetworkInfo &info);
     void bindServerInfo(QSqlQuery &query, const Network::Server &server);
 
+    //! Write the given message lists to the db using a single transaction
+    /** This is the actual insert path behind logMessages(). On success all messages
+     *  have their MsgId set, otherwise the whole group is rolled back.
+     */
+    bool commitMessages(const QList<MessageList *> &msgLists);
+
+    //! Create and fill the full-text index for the backlog, unless it already exists
+    /** The index needs SQLite's FTS5 extension. If it is not available, searchMsgs() falls
+     *  back to a (slow) substring match.
+     */
+    void setupSearchIndex();
+
+    // group commit: concurrent logMessages() calls from different sessions are
+    // combined into one transaction, written by whichever caller becomes the leader
+    struct GroupCommitRequest;
+    QMutex _commitMutex;
+    QWaitCondition _commitCondition;
+    QList<GroupCommitRequest *> _commitQueue;
+    int _commitQueueSize;
+    bool _commitInProgress;
+    int _commitWindow; // in ms
+    int _commitBatchSize;
+
     inline void lockForRead() { _dbLock.lockForRead(); }
     inline void lockForWrite() { _dbLock.lockForWrite(); }
     inline void unlock() { _dbLock.unlock(); }
+    // In WAL mode, backlog reads use their own read-only connections and don't need to wait for writers
+    inline void lockForBacklogRead() { if (!_walMode) _dbLock.lockForRead(); }
+    inline void unlockBacklogRead() { if (!_walMode) _dbLock.unlock(); }
     QReadWriteLock _dbLock;
     static int _maxRetryCount;
+
+    bool _walMode;
+    QString _synchronous;
+    int _walAutoCheckpoint;
+
+    bool _searchIndex; // true if the backlog_fts table is available
 };
 
 
@@ -402,6 +402,56 @@ public slots:
      */
     virtual QList<Message> requestAllMsgs(UserId user, MsgId first = -1, MsgId last = -1, int limit = -1) = 0;
 
+    //! Request the messages directly following a given message in its buffer
+    /** \param bufferId The buffer we request messages from
+     *  \param msgId    return only messages with a MsgId > msgId
+     *  \param limit    Max amount of messages
+     *  \return The requested list of messages, oldest first
+     */
+    virtual QList<Message> requestMsgsFollowing(UserId user, BufferId bufferId, MsgId msgId, int limit) = 0;
+
+    //! Search the backlog for messages containing all words of a query
+    /** \param query    The words to look for
+     *  \param bufferId if valid, only search this buffer; otherwise, search all of the user's buffers
+     *  \param before   if != -1 return only messages with a MsgId < before
+     *  \param limit    Max amount of messages
+     *  \return The matching messages, newest first
+     */
+    virtual QList<Message> searchMsgs(UserId user, const QString &query, BufferId bufferId = BufferId(), MsgId before = -1, int limit = -1) = 0;
+
+    /* Backlog retention */
+
+    //! Find the oldest message to keep when limiting a buffer to a number of messages
+    /** \param types  Only count messages of these types (ORed Message::Type values)
+     *  \param count  The number of messages to keep
+     *  \return The MsgId of the oldest message to keep, or an invalid MsgId if there are no more than count messages
+     */
+    virtual MsgId retentionCutoff(UserId user, BufferId bufferId, int types, int count) = 0;
+
+    //! Delete a batch of the oldest messages of a buffer
+    /** Only messages of the given types, with a MsgId < before and a timestamp older than olderThan are deleted,
+     *  oldest first.
+     *  \param before       if valid, delete only messages with a MsgId < before
+     *  \param olderThan    if valid, delete only messages older than this
+     *  \param limit        Max amount of messages to delete
+     *  \param deletedBytes Is set to the total size of the deleted message texts
+     *  \return The number of deleted messages, or -1 on error
+     */
+    virtual int deleteMsgs(UserId user, BufferId bufferId, int types, MsgId before, const QDateTime &olderThan, int limit, qint64 &deletedBytes) = 0;
+
+    //! Delete senders no longer referenced by any message
+    /** Checks at most limit senders with a senderid > lastSenderId, and advances lastSenderId
+     *  past them. Start with lastSenderId = 0.
+     *  \param deletedCount Is set to the number of deleted senders
+     *  \return false once all senders have been checked, or on error
+     */
+    virtual bool deleteOrphanedSenders(int &lastSenderId, int limit, int &deletedCount) = 0;
+
+    //! Space inside the database that has been freed by deletes and can be reused, in bytes
+    /** \return The amount of free space, or -1 if the backend can't tell
+     */
+    virtual qint64 reclaimableSpace() { return -1; }
+
 signals:
     //! Sent when a new BufferInfo is created, or an existing one changed somehow.
     void bufferInfoUpdated(UserId user, const BufferInfo &);
@@ -174,6 +174,30 @@ void ChatLine::setGeometryByWidth(const qreal &width, const qreal &contentsWidth
 }
 
 
+void ChatLine::setGeometry(const qreal &width,
+    const qreal &timestampWidth, const qreal &senderWidth, const qreal &contentsWidth,
+    const QPointF &senderPos, const QPointF &contentsPos, qreal &linePos)
+{
+    // linepos is the *bottom* position for the line
+    qreal height = _contentsItem.setGeometryByWidth(contentsWidth);
+    linePos -= height;
+    bool needGeometryChange = (height != _height || width != _width);
+
+    _timestampItem.setGeometry(timestampWidth, height);
+    _senderItem.setGeometry(senderWidth, height);
+    _senderItem.setPos(senderPos);
+    _contentsItem.setPos(contentsPos);
+
+    if (needGeometryChange) {
+        prepareGeometryChange();
+        _height = height;
+        _width = width;
+    }
+
+    setPos(0, linePos);
+}
+
+
 void ChatLine::setSelected(bool selected, ChatLineModel::ColumnType minColumn)
 {
     if (selected) {
@@ -70,6 +70,10 @@ public:
     // the _bottom_ position is passed via linePos. linePos is updated to the top of the chatLine.
     void setSecondColumn(const qreal &senderWidth, const qreal &contentsWidth, const QPointF &contentsPos, qreal &linePos);
     void setGeometryByWidth(const qreal &width, const qreal &contentsWidth, qreal &linePos);
+    // sets up all columns at once, used for lines whose layout has been deferred by the scene
+    void setGeometry(const qreal &width,
+        const qreal &timestampWidth, const qreal &senderWidth, const qreal &contentsWidth,
+        const QPointF &senderPos, const QPointF &contentsPos, qreal &linePos);
 
     void setSelected(bool selected, ChatLineModel::ColumnType minColumn = ChatLineModel::ContentsColumn);
     void setHighlighted(bool highlighted);
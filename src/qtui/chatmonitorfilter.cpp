@@ -62,19 +62,22 @@ bool ChatMonitorFilter::filterAcceptsRow(int sourceRow, const QModelIndex &sourc
 {
     Q_UNUSED(sourceParent)
 
-    QModelIndex source_index = sourceModel()->index(sourceRow, 0);
-    BufferId bufferId = source_index.data(MessageModel::BufferIdRole).value<BufferId>();
+    const MessageModelItem *item = sourceItem(sourceRow);
+    if (!item)
+        return false;
 
-    Message::Flags flags = (Message::Flags)source_index.data(MessageModel::FlagsRole).toInt();
-    if ((flags & Message::Backlog) && (!_showBacklog || (!_includeRead &&
-        (Client::networkModel()->lastSeenMsgId(bufferId) >= sourceModel()->data(source_index, MessageModel::MsgIdRole).value<MsgId>()))))
+    Message::Type type = item->msgType();
+    if (!(type & (Message::Plain | Message::Notice | Message::Action)))
         return false;
 
-    if (!_showOwnMessages && flags & Message::Self)
+    BufferId bufferId = item->bufferId();
+
+    Message::Flags flags = item->msgFlags();
+    if ((flags & Message::Backlog) && (!_showBacklog || (!_includeRead &&
+        (Client::networkModel()->lastSeenMsgId(bufferId) >= item->msgId()))))
         return false;
 
-    Message::Type type = (Message::Type)source_index.data(MessageModel::TypeRole).toInt();
-    if (!(type & (Message::Plain | Message::Notice | Message::Action)))
+    if (!_showOwnMessages && flags & Message::Self)
         return false;
 
     // ChatMonitorSettingsPage
@@ -90,7 +93,7 @@ bool ChatMonitorFilter::filterAcceptsRow(int sourceRow, const QModelIndex &sourc
     // ignorelist handling
     // only match if message is not flagged as server msg
     if (!(flags & Message::ServerMsg) && Client::ignoreListManager()
-        && Client::ignoreListManager()->match(source_index.data(MessageModel::MessageRole).value<Message>(), Client::networkModel()->networkName(bufferId)))
+        && Client::ignoreListManager()->match(item->message(), Client::networkModel()->networkName(bufferId)))
         return false;
     return true;
 }
@@ -58,6 +58,7 @@
 #include "webpreviewitem.h"
 
 const qreal minContentsWidth = 200;
+const int deferredLayoutChunkSize = 200; // rows laid out per idle step
 
 ChatScene::ChatScene(QAbstractItemModel *model, const QString &idString, qreal width, ChatView *parent)
     : QGraphicsScene(0, 0, width, 0, (QObject *)parent),
@@ -68,6 +69,8 @@ ChatScene::ChatScene(QAbstractItemModel *model, const QString &idString, qreal w
     _sceneRect(0, 0, width, 0),
     _firstLineRow(-1),
     _viewportHeight(0),
+    _deferredLayoutRows(0),
+    _deferredLayoutOffset(0),
     _markerLine(new MarkerLineItem(width)),
     _markerLineVisible(false),
     _markerLineValid(false),
@@ -133,6 +136,9 @@ ChatScene::ChatScene(QAbstractItemModel *model, const QString &idString, qreal w
     _clickTimer.setSingleShot(true);
     connect(&_clickTimer, SIGNAL(timeout()), SLOT(clickTimeout()));
 
+    _deferredLayoutTimer.setInterval(0);
+    connect(&_deferredLayoutTimer, SIGNAL(timeout()), SLOT(deferredLayoutTimeout()));
+
     setItemIndexMethod(QGraphicsScene::NoIndex);
 }
 
@@ -275,7 +281,7 @@ void ChatScene::setMarkerLine(MsgId msgId)
             markerLine()->setChatLine(line);
             // if this was the last line, we won't see it because it's outside the sceneRect
             // .. which is exactly what we want :)
-            markerLine()->setPos(line->pos() + QPointF(0, line->height()));
+            markerLine()->setPos(0, lineBottom(line->row()));
 
             // DayChange messages might have been hidden outside the scene rect, don't make the markerline visible then!
             if (markerLine()->pos().y() >= sceneRect().y()) {
@@ -350,6 +356,10 @@ void ChatScene::rowsInserted(const QModelIndex &index, int start, int end)
     bool atBottom = (start == _lines.count());
     bool atTop = !atBottom && (start == 0);
 
+    // new lines are placed relative to the existing ones, so those need their final positions
+    if (!atBottom || _deferredLayoutRows == _lines.count())
+        applyDeferredLayoutOffset();
+
     if (start < _lines.count()) {
         y = _lines.value(start)->y();
     }
@@ -393,6 +403,10 @@ void ChatScene::rowsInserted(const QModelIndex &index, int start, int end)
         _lines[i]->setRow(i);
     }
 
+    // new lines are laid out properly already, but they shift the deferred ones
+    if (start < _deferredLayoutRows)
+        _deferredLayoutRows += end - start + 1;
+
     // update selection
     if (_selectionStart >= 0) {
         int offset = end - start + 1;
@@ -472,6 +486,8 @@ void ChatScene::rowsAboutToBeRemoved(const QModelIndex &parent, int start, int e
     bool atTop = (start == 0);
     bool atBottom = (end == _lines.count() - 1);
 
+    applyDeferredLayoutOffset();
+
     // clear selection
     if (_selectingItem) {
         int row = _selectingItem->row();
@@ -496,6 +512,9 @@ void ChatScene::rowsAboutToBeRemoved(const QModelIndex &parent, int start, int e
         _lines.at(i)->setRow(i);
     }
 
+    if (start < _deferredLayoutRows)
+        _deferredLayoutRows = qMax(start, _deferredLayoutRows - (end - start + 1));
+
     // update selection
     if (_selectionStart >= 0) {
         int offset = end - start + 1;
@@ -582,7 +601,7 @@ void ChatScene::setWidth(qreal width)
 {
     if (width == _sceneRect.width())
         return;
-    layout(0, _lines.count()-1, width);
+    relayout(width);
 }
 
 
@@ -594,25 +613,11 @@ void ChatScene::layout(int start, int end, qreal width)
     // 2 to 10 times faster!
     //setItemIndexMethod(QGraphicsScene::NoIndex);
 
+    applyDeferredLayoutOffset();
     if (end >= 0) {
-        int row = end;
-        qreal linePos = _lines.at(row)->scenePos().y() + _lines.at(row)->height();
-        qreal contentsWidth = width - secondColumnHandle()->sceneRight();
-        while (row >= start) {
-            _lines.at(row--)->setGeometryByWidth(width, contentsWidth, linePos);
-        }
-
-        if (row >= 0) {
-            // remaining items don't need geometry changes, but maybe repositioning?
-            ChatLine *line = _lines.at(row);
-            qreal offset = linePos - (line->scenePos().y() + line->height());
-            if (offset != 0) {
-                while (row >= 0) {
-                    line = _lines.at(row--);
-                    line->setPos(0, line->scenePos().y() + offset);
-                }
-            }
-        }
+        // remaining items don't need geometry changes, but maybe repositioning?
+        qreal offset = layoutLines(start, end, width, false);
+        moveLines(0, start - 1, offset);
     }
 
     //setItemIndexMethod(QGraphicsScene::BspTreeIndex);
@@ -644,6 +649,7 @@ void ChatScene::firstHandlePositionChanged(qreal xpos)
     // 2 to 10 times faster!
     //setItemIndexMethod(QGraphicsScene::NoIndex);
 
+    // the contents width doesn't change, so there's no need to wrap anything
     QList<ChatLine *>::iterator lineIter = _lines.end();
     QList<ChatLine *>::iterator lineIterBegin = _lines.begin();
     qreal timestampWidth = firstColumnHandle()->sceneLeft();
@@ -674,30 +680,146 @@ void ChatScene::secondHandlePositionChanged(qreal xpos)
     ChatViewSettings defaultSettings;
     defaultSettings.setValue("SecondColumnHandlePos", _secondColHandlePos);
 
-    // clock_t startT = clock();
+    relayout(_sceneRect.width());
+}
 
-    // disabling the index while doing this complex updates is about
-    // 2 to 10 times faster!
-    //setItemIndexMethod(QGraphicsScene::NoIndex);
 
-    QList<ChatLine *>::iterator lineIter = _lines.end();
-    QList<ChatLine *>::iterator lineIterBegin = _lines.begin();
-    qreal linePos = _sceneRect.y() + _sceneRect.height();
+// Lays out the lines from the viewport downwards right away. The ones above are laid out
+// later on, when the event loop is idle. Working bottom up ensures that the visible lines
+// don't move around afterwards.
+void ChatScene::relayout(qreal width)
+{
+    applyDeferredLayoutOffset();
+    int start = firstLayoutRow();
+    _deferredLayoutOffset = layoutLines(start, _lines.count() - 1, width, true);
+
+    _deferredLayoutRows = start;
+    if (_deferredLayoutRows > 0)
+        _deferredLayoutTimer.start();
+    else
+        _deferredLayoutTimer.stop();
+
+    updateSceneRect(width);
+    setHandleXLimits();
+    setMarkerLine();
+    emit layoutChanged();
+}
+
+
+// Lays out rows [start, end] bottom up, beginning at the current bottom of row end. If allColumns
+// is false, only the width changed; otherwise the column handles were moved as well.
+// Returns how far the rows above start have to be moved to stay stacked on top.
+qreal ChatScene::layoutLines(int start, int end, qreal width, bool allColumns)
+{
+    if (end < start)
+        return 0;
+
+    qreal timestampWidth = firstColumnHandle()->sceneLeft();
     qreal senderWidth = secondColumnHandle()->sceneLeft() - firstColumnHandle()->sceneRight();
-    qreal contentsWidth = _sceneRect.width() - secondColumnHandle()->sceneRight();
+    qreal contentsWidth = width - secondColumnHandle()->sceneRight();
+    QPointF senderPos(firstColumnHandle()->sceneRight(), 0);
     QPointF contentsPos(secondColumnHandle()->sceneRight(), 0);
-    while (lineIter != lineIterBegin) {
-        --lineIter;
-        (*lineIter)->setSecondColumn(senderWidth, contentsWidth, contentsPos, linePos);
+
+    int row = end;
+    qreal linePos = lineBottom(row);
+    while (row >= start) {
+        if (allColumns)
+            _lines.at(row--)->setGeometry(width, timestampWidth, senderWidth, contentsWidth, senderPos, contentsPos, linePos);
+        else
+            _lines.at(row--)->setGeometryByWidth(width, contentsWidth, linePos);
     }
-    //setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+
+    if (row < 0)
+        return 0;
+    ChatLine *line = _lines.at(row);
+    return linePos - (line->pos().y() + line->height());
+}
+
+
+void ChatScene::moveLines(int start, int end, qreal offset)
+{
+    if (offset == 0)
+        return;
+
+    for (int row = start; row <= end; row++) {
+        ChatLine *line = _lines.at(row);
+        line->setPos(0, line->pos().y() + offset);
+    }
+}
+
+
+void ChatScene::applyDeferredLayoutOffset()
+{
+    moveLines(0, _deferredLayoutRows - 1, _deferredLayoutOffset);
+    _deferredLayoutOffset = 0;
+}
+
+
+qreal ChatScene::lineTop(int row) const
+{
+    qreal top = _lines.at(row)->pos().y();
+    if (row < _deferredLayoutRows)
+        top += _deferredLayoutOffset;
+    return top;
+}
+
+
+qreal ChatScene::lineBottom(int row) const
+{
+    return lineTop(row) + _lines.at(row)->height();
+}
+
+
+void ChatScene::layoutDeferredRows(int start)
+{
+    if (start >= _deferredLayoutRows)
+        return;
+
+    // rather than moving all rows above for every chunk, they are only moved once they get laid out themselves
+    _deferredLayoutOffset = layoutLines(start, _deferredLayoutRows - 1, _sceneRect.width(), true);
+    _deferredLayoutRows = start;
+    if (!_deferredLayoutRows)
+        _deferredLayoutTimer.stop();
 
     updateSceneRect();
-    setHandleXLimits();
+    setMarkerLine();
     emit layoutChanged();
+}
 
-//   clock_t endT = clock();
-//   qDebug() << "resized" << _lines.count() << "in" << (float)(endT - startT) / CLOCKS_PER_SEC << "sec";
+
+void ChatScene::deferredLayoutTimeout()
+{
+    layoutDeferredRows(qMax(0, _deferredLayoutRows - deferredLayoutChunkSize));
+}
+
+
+void ChatScene::layoutViewport()
+{
+    // make sure that we never show lines with outdated geometry when scrolling up
+    layoutDeferredRows(firstLayoutRow());
+}
+
+
+// returns the first row that is visible or within one page above the viewport
+int ChatScene::firstLayoutRow() const
+{
+    if (!chatView())
+        return 0;
+
+    QWidget *viewport = chatView()->viewport();
+    qreal top = chatView()->mapToScene(viewport->rect().topLeft()).y() - viewport->height();
+
+    // lines are stacked without gaps, so we can do a binary search on their positions
+    int low = 0;
+    int high = _lines.count();
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (lineBottom(mid) <= top)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
 }
 
 
@@ -1151,9 +1273,8 @@ void ChatScene::updateSceneRect(qreal width)
 
     // the following call should be safe. If it crashes something went wrong during insert/remove
     if (_firstLineRow < _lines.count()) {
-        ChatLine *firstLine = _lines.at(_firstLineRow);
-        ChatLine *lastLine = _lines.last();
-        updateSceneRect(QRectF(0, firstLine->pos().y(), width, lastLine->pos().y() + lastLine->height() - firstLine->pos().y()));
+        qreal top = lineTop(_firstLineRow);
+        updateSceneRect(QRectF(0, top, width, lineBottom(_lines.count() - 1) - top));
     }
     else {
         // empty scene rect
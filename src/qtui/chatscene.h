@@ -129,6 +129,7 @@ public slots:
     void updateForViewport(qreal width, qreal height);
     void setWidth(qreal width);
     void layout(int start, int end, qreal width);
+    void layoutViewport();
 
     void resetColumnWidths();
 
@@ -184,8 +185,18 @@ private slots:
 
     void clickTimeout();
 
+    void deferredLayoutTimeout();
+
 private:
     void setHandleXLimits();
+    void relayout(qreal width);
+    qreal layoutLines(int start, int end, qreal width, bool allColumns);
+    void moveLines(int start, int end, qreal offset);
+    void applyDeferredLayoutOffset();
+    void layoutDeferredRows(int start);
+    int firstLayoutRow() const;
+    qreal lineTop(int row) const;
+    qreal lineBottom(int row) const;
     void updateSelection(const QPointF &pos);
 
     ChatView *_chatView;
@@ -203,6 +214,14 @@ private:
     void updateSceneRect(const QRectF &rect);
     qreal _viewportHeight;
 
+    // rows [0, _deferredLayoutRows) still have the geometry of a previous width or column layout.
+    // They sit above the viewport and are laid out piecewise whenever the event loop is idle.
+    // Until then, they'd have to be moved by _deferredLayoutOffset to stay stacked on top of the others;
+    // lineTop() and lineBottom() take that into account.
+    int _deferredLayoutRows;
+    qreal _deferredLayoutOffset;
+    QTimer _deferredLayoutTimer;
+
     MarkerLineItem *_markerLine;
     bool _markerLineVisible, _markerLineValid, _markerLineJumpPending;
 
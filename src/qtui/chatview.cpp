@@ -386,6 +386,7 @@ void ChatView::invalidateFilter()
 void ChatView::scrollContentsBy(int dx, int dy)
 {
     QGraphicsView::scrollContentsBy(dx, dy);
+    scene()->layoutViewport();
     checkChatLineCaches();
 }
 
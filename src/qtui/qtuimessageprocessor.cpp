@@ -114,55 +114,27 @@ void QtUiMessageProcessor::checkForHighlight(Message &msg)
     if (!((msg.type() & (Message::Plain | Message::Notice | Message::Action)) && !(msg.flags() & Message::Self)))
         return;
 
-    // TODO: Cache this (per network)
     const Network *net = Client::network(msg.bufferInfo().networkId());
     if (net && !net->myNick().isEmpty()) {
-        QStringList nickList;
-        if (_highlightNick == NotificationSettings::CurrentNick) {
-            nickList << net->myNick();
-        }
-        else if (_highlightNick == NotificationSettings::AllNicks) {
-            const Identity *myIdentity = Client::identity(net->identity());
-            if (myIdentity)
-                nickList = myIdentity->nicks();
-            if (!nickList.contains(net->myNick()))
-                nickList.prepend(net->myNick());
+        const QString &contents = msg.contents();
+        const QRegExp &nickRx = nickRegExp(net);
+        if (!nickRx.isEmpty() && nickRx.indexIn(contents) >= 0) {
+            msg.setFlags(msg.flags() | Message::Highlight);
+            return;
         }
-        foreach(QString nickname, nickList) {
-            QRegExp nickRegExp("(^|\\W)" + QRegExp::escape(nickname) + "(\\W|$)", _nicksCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
-            if (nickRegExp.indexIn(msg.contents()) >= 0) {
+
+        for (int i = 0; i < _globalRegExps.count(); i++) {
+            if (_globalRegExps.at(i).indexIn(contents) >= 0) {
                 msg.setFlags(msg.flags() | Message::Highlight);
                 return;
             }
         }
 
-        for (int i = 0; i < _highlightRules.count(); i++) {
-            const HighlightRule &rule = _highlightRules.at(i);
-            if (!rule.isEnabled)
-                continue;
-
-            if (rule.chanName.size() > 0 && rule.chanName.compare(".*") != 0) {
-                if (rule.chanName.startsWith("!")) {
-                    QRegExp rx(rule.chanName.mid(1), Qt::CaseInsensitive);
-                    if (rx.exactMatch(msg.bufferInfo().bufferName()))
-                        continue;
-                }
-                else {
-                    QRegExp rx(rule.chanName, Qt::CaseInsensitive);
-                    if (!rx.exactMatch(msg.bufferInfo().bufferName()))
-                        continue;
-                }
-            }
+        if (_channelRules.isEmpty())
+            return;
 
-            QRegExp rx;
-            if (rule.isRegExp) {
-                rx = QRegExp(rule.name, rule.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
-            }
-            else {
-                rx = QRegExp("(^|\\W)" + QRegExp::escape(rule.name) + "(\\W|$)", rule.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
-            }
-            bool match = (rx.indexIn(msg.contents()) >= 0);
-            if (match) {
+        foreach(int ruleIndex, bufferRules(msg.bufferInfo().bufferName())) {
+            if (_highlightRules.at(ruleIndex).regExp.indexIn(contents) >= 0) {
                 msg.setFlags(msg.flags() | Message::Highlight);
                 return;
             }
@@ -171,9 +143,66 @@ void QtUiMessageProcessor::checkForHighlight(Message &msg)
 }
 
 
+const QRegExp &QtUiMessageProcessor::nickRegExp(const Network *network)
+{
+    QStringList nickList;
+    if (_highlightNick == NotificationSettings::CurrentNick) {
+        nickList << network->myNick();
+    }
+    else if (_highlightNick == NotificationSettings::AllNicks) {
+        const Identity *myIdentity = Client::identity(network->identity());
+        if (myIdentity)
+            nickList = myIdentity->nicks();
+        if (!nickList.contains(network->myNick()))
+            nickList.prepend(network->myNick());
+    }
+
+    NickMatcher &matcher = _nickMatchers[network->networkId()];
+    if (matcher.nicks != nickList) {
+        matcher.nicks = nickList;
+        if (nickList.isEmpty()) {
+            matcher.regExp = QRegExp();
+        }
+        else {
+            QStringList escapedNicks;
+            foreach(const QString &nickname, nickList)
+                escapedNicks << QRegExp::escape(nickname);
+            matcher.regExp = QRegExp("(^|\\W)(?:" + escapedNicks.join("|") + ")(\\W|$)", _nicksCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+        }
+    }
+    return matcher.regExp;
+}
+
+
+const QList<int> &QtUiMessageProcessor::bufferRules(const QString &bufferName)
+{
+    QHash<QString, QList<int> >::const_iterator it = _bufferRules.constFind(bufferName);
+    if (it != _bufferRules.constEnd())
+        return it.value();
+
+    QList<int> rules;
+    foreach(int ruleIndex, _channelRules) {
+        const HighlightRule &rule = _highlightRules.at(ruleIndex);
+        if (rule.chanName.startsWith("!")) {
+            QRegExp rx(rule.chanName.mid(1), Qt::CaseInsensitive);
+            if (rx.exactMatch(bufferName))
+                continue;
+        }
+        else {
+            QRegExp rx(rule.chanName, Qt::CaseInsensitive);
+            if (!rx.exactMatch(bufferName))
+                continue;
+        }
+        rules << ruleIndex;
+    }
+    return _bufferRules.insert(bufferName, rules).value();
+}
+
+
 void QtUiMessageProcessor::nicksCaseSensitiveChanged(const QVariant &variant)
 {
     _nicksCaseSensitive = variant.toBool();
+    _nickMatchers.clear();
 }
 
 
@@ -192,10 +221,43 @@ void QtUiMessageProcessor::highlightListChanged(const QVariant &variant)
             rule["Channel"].toString());
         ++iter;
     }
+
+    // compile the rules: plain words without channel restriction are combined into one regexp per case sensitivity,
+    // everything else gets its own
+    _globalRegExps.clear();
+    _channelRules.clear();
+    _bufferRules.clear();
+    QStringList plainWords[2];
+    for (int i = 0; i < _highlightRules.count(); i++) {
+        HighlightRule &rule = _highlightRules[i];
+        if (!rule.isEnabled)
+            continue;
+
+        bool hasChannel = rule.chanName.size() > 0 && rule.chanName.compare(".*") != 0;
+        if (!rule.isRegExp && !hasChannel) {
+            plainWords[rule.caseSensitive == Qt::CaseSensitive ? 1 : 0] << QRegExp::escape(rule.name);
+            continue;
+        }
+
+        if (rule.isRegExp)
+            rule.regExp = QRegExp(rule.name, rule.caseSensitive);
+        else
+            rule.regExp = QRegExp("(^|\\W)" + QRegExp::escape(rule.name) + "(\\W|$)", rule.caseSensitive);
+
+        if (hasChannel)
+            _channelRules << i;
+        else
+            _globalRegExps << rule.regExp;
+    }
+    for (int cs = 0; cs < 2; cs++) {
+        if (!plainWords[cs].isEmpty())
+            _globalRegExps << QRegExp("(^|\\W)(?:" + plainWords[cs].join("|") + ")(\\W|$)", cs ? Qt::CaseSensitive : Qt::CaseInsensitive);
+    }
 }
 
 
 void QtUiMessageProcessor::highlightNickChanged(const QVariant &variant)
 {
     _highlightNick = (NotificationSettings::HighlightNickType)variant.toInt();
+    _nickMatchers.clear();
 }
@@ -21,10 +21,14 @@
 #ifndef QTUIMESSAGEPROCESSOR_H_
 #define QTUIMESSAGEPROCESSOR_H_
 
+#include <QHash>
+#include <QRegExp>
 #include <QTimer>
 
 #include "abstractmessageprocessor.h"
 
+class Network;
+
 class QtUiMessageProcessor : public AbstractMessageProcessor
 {
     Q_OBJECT
@@ -56,6 +60,11 @@ private:
     void checkForHighlight(Message &msg);
     void startProcessing();
 
+    //! @return the regexp matching any of our nicks on the given network, rebuilt whenever the nicks change
+    const QRegExp &nickRegExp(const Network *network);
+    //! @return the indices of the channel specific rules that apply to the given buffer
+    const QList<int> &bufferRules(const QString &bufferName);
+
     QList<QList<Message> > _processQueue;
     QList<Message> _currentBatch;
     QTimer _processTimer;
@@ -68,13 +77,25 @@ private:
         Qt::CaseSensitivity caseSensitive;
         bool isRegExp;
         QString chanName;
+        QRegExp regExp; // the compiled rule
         inline HighlightRule(const QString &name, bool enabled, Qt::CaseSensitivity cs, bool regExp, const QString &chanName)
             : name(name), isEnabled(enabled), caseSensitive(cs), isRegExp(regExp), chanName(chanName) {}
     };
 
+    struct NickMatcher {
+        QStringList nicks;
+        QRegExp regExp;
+    };
+
     QList<HighlightRule> _highlightRules;
     NotificationSettings::HighlightNickType _highlightNick;
     bool _nicksCaseSensitive;
+
+    // compiled from _highlightRules by highlightListChanged()
+    QList<QRegExp> _globalRegExps; // all enabled rules without a channel restriction, plain words combined into one per case sensitivity
+    QList<int> _channelRules;      // indices of the enabled rules with a channel restriction
+    QHash<QString, QList<int> > _bufferRules; // keyed by buffer name, see bufferRules()
+    QHash<NetworkId, NickMatcher> _nickMatchers;
 };
 
 